@@ -0,0 +1,1222 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "test_atn.hpp"
+
+#include <antlr/v4/runtime/atn/atn_deserialization_options.hpp>
+#include <antlr/v4/runtime/atn/atn_optimizer.hpp>
+#include <antlr/v4/runtime/atn/atn_post_processor.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/binary_atn.hpp>
+#include <antlr/v4/runtime/atn/epsilon_closure_table.hpp>
+#include <antlr/v4/runtime/atn/ll1_analyzer.hpp>
+#include <antlr/v4/runtime/atn/lookahead_table.hpp>
+#include <antlr/v4/runtime/atn/prediction_mode_tuner.hpp>
+#include <antlr/v4/runtime/atn/ll1_decision_table.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/lexer_action.hpp>
+#include <antlr/v4/runtime/atn/static_atn.hpp>
+#include <antlr/v4/runtime/atn/static_atn_writer.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+#include <antlr/v4/runtime/dfa/decision_dfa.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr {
+namespace test {
+
+	using namespace antlr4::atn;
+
+	namespace {
+
+		// ------------ SUPPORT -------------------------
+
+		template<typename State>
+		std::shared_ptr<State> add_state(grammar_atn& atn, size_t rule_index = 0)
+		{
+			std::shared_ptr<State> state = std::make_shared<State>(atn.states().size(), rule_index);
+			atn.add_state(state);
+			return state;
+		}
+
+		std::shared_ptr<rule_start_state> add_rule(grammar_atn& atn)
+		{
+			std::shared_ptr<rule_start_state> start = add_state<rule_start_state>(atn, atn.rule_start_states().size());
+			start->stop_state(add_state<rule_stop_state>(atn, start->rule_index()));
+			atn.add_rule_start_state(start);
+			return start;
+		}
+
+		typedef std::shared_ptr<transition> (*make_transition)(std::shared_ptr<atn_state> const& target);
+
+		// Adds a decision block to rule_index of atn with one alternative for each element of alternatives, each consisting of
+		// a new state with the transition made by the element, and returns the start and end of the block.
+		std::pair<std::shared_ptr<basic_block_start_state>, std::shared_ptr<block_end_state>> add_block(grammar_atn& atn, size_t rule_index, std::vector<make_transition> const& alternatives)
+		{
+			std::shared_ptr<basic_block_start_state> block_start = add_state<basic_block_start_state>(atn, rule_index);
+			std::shared_ptr<block_end_state> block_end = add_state<block_end_state>(atn, rule_index);
+			block_start->end_state(block_end);
+			block_end->start_state(block_start);
+			atn.add_decision_state(block_start);
+			for each (make_transition make in alternatives)
+			{
+				std::shared_ptr<basic_state> alternative = add_state<basic_state>(atn, rule_index);
+				block_start->add_transition(std::make_shared<epsilon_transition>(alternative, -1));
+				alternative->add_transition(make(block_end));
+			}
+
+			return std::make_pair(block_start, block_end);
+		}
+
+		template<int32_t Token>
+		std::shared_ptr<transition> match(std::shared_ptr<atn_state> const& target)
+		{
+			return std::make_shared<atom_transition>(target, Token);
+		}
+
+		std::shared_ptr<transition> empty(std::shared_ptr<atn_state> const& target)
+		{
+			return std::make_shared<epsilon_transition>(target, -1);
+		}
+
+		std::shared_ptr<transition> predicated(std::shared_ptr<atn_state> const& target)
+		{
+			return std::make_shared<predicate_transition>(target, 0, 0, false);
+		}
+
+		// r0 : (A | B | ) ;  r1 : r0 C (A | A) ;  r2 : ({p}? | B) ;
+		std::shared_ptr<grammar_atn> create_decision_atn()
+		{
+			std::shared_ptr<grammar_atn> atn = std::make_shared<grammar_atn>(atn_type::parser, 4);
+			std::shared_ptr<rule_start_state> r0 = add_rule(*atn);
+			std::shared_ptr<rule_start_state> r1 = add_rule(*atn);
+			std::shared_ptr<rule_start_state> r2 = add_rule(*atn);
+
+			auto block0 = add_block(*atn, 0, std::vector<make_transition> { &match<1>, &match<2>, &empty });
+			r0->add_transition(std::make_shared<epsilon_transition>(block0.first, -1));
+			block0.second->add_transition(std::make_shared<epsilon_transition>(r0->stop_state(), -1));
+
+			auto block1 = add_block(*atn, 1, std::vector<make_transition> { &match<1>, &match<1> });
+			std::shared_ptr<basic_state> call = add_state<basic_state>(*atn, 1);
+			std::shared_ptr<basic_state> follow = add_state<basic_state>(*atn, 1);
+			r1->add_transition(std::make_shared<epsilon_transition>(call, -1));
+			call->add_transition(std::make_shared<rule_transition>(r0, 0, 0, follow));
+			follow->add_transition(std::make_shared<atom_transition>(block1.first, 3));
+			r0->stop_state()->add_transition(std::make_shared<epsilon_transition>(follow, -1));
+			block1.second->add_transition(std::make_shared<epsilon_transition>(r1->stop_state(), -1));
+
+			auto block2 = add_block(*atn, 2, std::vector<make_transition> { &predicated, &match<2> });
+			r2->add_transition(std::make_shared<epsilon_transition>(block2.first, -1));
+			block2.second->add_transition(std::make_shared<epsilon_transition>(r2->stop_state(), -1));
+
+			return atn;
+		}
+
+		// r0 : (A | B C | D) ; where merging A and D into a set reorders the optimized transitions of the decision
+		std::shared_ptr<grammar_atn> create_merged_atn()
+		{
+			std::shared_ptr<grammar_atn> atn = std::make_shared<grammar_atn>(atn_type::parser, 4);
+			std::shared_ptr<rule_start_state> r0 = add_rule(*atn);
+			std::shared_ptr<basic_block_start_state> block_start = add_state<basic_block_start_state>(*atn);
+			std::shared_ptr<block_end_state> block_end = add_state<block_end_state>(*atn);
+			block_start->end_state(block_end);
+			block_end->start_state(block_start);
+			atn->add_decision_state(block_start);
+			r0->add_transition(std::make_shared<epsilon_transition>(block_start, -1));
+			block_end->add_transition(std::make_shared<epsilon_transition>(r0->stop_state(), -1));
+
+			std::shared_ptr<basic_state> alt1 = add_state<basic_state>(*atn);
+			std::shared_ptr<basic_state> alt2 = add_state<basic_state>(*atn);
+			std::shared_ptr<basic_state> after2 = add_state<basic_state>(*atn);
+			std::shared_ptr<basic_state> alt3 = add_state<basic_state>(*atn);
+			block_start->add_transition(std::make_shared<epsilon_transition>(alt1, -1));
+			block_start->add_transition(std::make_shared<epsilon_transition>(alt2, -1));
+			block_start->add_transition(std::make_shared<epsilon_transition>(alt3, -1));
+			alt1->add_transition(std::make_shared<atom_transition>(block_end, 1));
+			alt2->add_transition(std::make_shared<atom_transition>(after2, 2));
+			after2->add_transition(std::make_shared<atom_transition>(block_end, 3));
+			alt3->add_transition(std::make_shared<atom_transition>(block_end, 4));
+			return atn;
+		}
+
+		template<int32_t Token>
+		int32_t constant(size_t)
+		{
+			return Token;
+		}
+
+		// r0 : ('a'..'c' | 'x'..'z' | '0') ; in the form emitted by static_atn_writer
+		const static_atn::state static_lexer_states[] =
+		{
+			{ atn_state::atn_state_type::rule_start, 0u, 1u, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::rule_stop, 0u, static_atn::no_state, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::block_start, 0u, 3u, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::block_end, 0u, 2u, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::basic, 0u, static_atn::no_state, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::basic, 0u, static_atn::no_state, static_atn::no_state, 0u },
+		};
+
+		const uint32_t static_lexer_transition_offsets[] = { 0u, 1u, 1u, 3u, 4u, 5u, 6u };
+
+		const transition_table::entry static_lexer_transitions[] =
+		{
+			{ transition::transition_type::epsilon, 0u, 0, 2u, -1, 0 },
+			{ transition::transition_type::epsilon, 0u, 0, 4u, -1, 0 },
+			{ transition::transition_type::epsilon, 0u, 0, 5u, -1, 0 },
+			{ transition::transition_type::epsilon, 0u, 0, 1u, -1, 0 },
+			{ transition::transition_type::set, 0u, 0, 3u, 0, 2 },
+			{ transition::transition_type::atom, 0u, 0, 3u, '0', '0' + 1 },
+		};
+
+		const transition_table::interval static_lexer_intervals[] = { { 'a', 'c' + 1 }, { 'x', 'z' + 1 } };
+
+		const uint32_t static_lexer_rule_start_states[] = { 0u };
+
+		const uint32_t static_lexer_decision_states[] = { 2u };
+
+		const static_atn static_lexer =
+		{
+			atn_type::lexer,
+			127,
+			6,
+			static_lexer_states,
+			static_lexer_transition_offsets,
+			static_lexer_transitions,
+			2,
+			static_lexer_intervals,
+			nullptr,
+			nullptr,
+			0,
+			nullptr,
+			1,
+			static_lexer_rule_start_states,
+			1,
+			static_lexer_decision_states,
+			0,
+			nullptr,
+		};
+
+		// r0 : (A | ~A) ; in the form emitted by static_atn_writer, with a vocabulary of A and B
+		const static_atn::state static_parser_states[] =
+		{
+			{ atn_state::atn_state_type::rule_start, 0u, 1u, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::rule_stop, 0u, static_atn::no_state, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::block_start, 0u, 3u, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::block_end, 0u, 2u, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::basic, 0u, static_atn::no_state, static_atn::no_state, 0u },
+			{ atn_state::atn_state_type::basic, 0u, static_atn::no_state, static_atn::no_state, 0u },
+		};
+
+		const uint32_t static_parser_transition_offsets[] = { 0u, 1u, 1u, 3u, 4u, 5u, 6u };
+
+		const transition_table::entry static_parser_transitions[] =
+		{
+			{ transition::transition_type::epsilon, 0u, 0, 2u, -1, 0 },
+			{ transition::transition_type::epsilon, 0u, 0, 4u, -1, 0 },
+			{ transition::transition_type::epsilon, 0u, 0, 5u, -1, 0 },
+			{ transition::transition_type::epsilon, 0u, 0, 1u, -1, 0 },
+			{ transition::transition_type::atom, 0u, 0, 3u, 1, 2 },
+			{ transition::transition_type::not_set, 0u, 0, 3u, 0, 1 },
+		};
+
+		const transition_table::interval static_parser_intervals[] = { { 2, 3 } };
+
+		const uint32_t static_parser_rule_start_states[] = { 0u };
+
+		const uint32_t static_parser_decision_states[] = { 2u };
+
+		const static_atn static_parser =
+		{
+			atn_type::parser,
+			2,
+			6,
+			static_parser_states,
+			static_parser_transition_offsets,
+			static_parser_transitions,
+			1,
+			static_parser_intervals,
+			nullptr,
+			nullptr,
+			0,
+			nullptr,
+			1,
+			static_parser_rule_start_states,
+			1,
+			static_parser_decision_states,
+			0,
+			nullptr,
+		};
+
+		// Writes the binary image of atn to memory aligned as a mapped file, which is page aligned, setting size to its
+		// size in bytes.
+		std::vector<uint64_t> write_image(grammar_atn& atn, size_t& size)
+		{
+			atn.build_transition_table();
+			std::ostringstream out;
+			binary_atn::write(out, atn, std::vector<std::shared_ptr<antlr4::atn::lexer_action>>());
+			std::string bytes = out.str();
+			std::vector<uint64_t> image((bytes.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+			std::copy(bytes.begin(), bytes.end(), reinterpret_cast<char*>(image.data()));
+			size = bytes.size();
+			return image;
+		}
+
+		// Whether a binary_atn rejects a copy of image where the value at field, which points into image, is value.
+		template<typename T>
+		bool rejects(std::vector<uint64_t> const& image, size_t size, T const* field, T value)
+		{
+			std::vector<uint64_t> corrupt(image);
+			size_t offset = reinterpret_cast<char const*>(field) - reinterpret_cast<char const*>(image.data());
+			*reinterpret_cast<T*>(reinterpret_cast<char*>(corrupt.data()) + offset) = value;
+			try
+			{
+				binary_atn atn(corrupt.data(), size);
+			}
+			catch (std::invalid_argument const&)
+			{
+				return true;
+			}
+
+			return false;
+		}
+
+		// r0 : A* r1 ;  r1 : A* r2 ;  ...  rn : A* ;  leaving the links made by atn_post_processor unset
+		std::shared_ptr<grammar_atn> create_loop_atn(size_t rule_count)
+		{
+			std::shared_ptr<grammar_atn> atn = std::make_shared<grammar_atn>(atn_type::parser, 2);
+			std::vector<std::shared_ptr<rule_stop_state>> stop_states;
+			for (size_t i = 0; i < rule_count; i++)
+			{
+				atn->add_rule_start_state(add_state<rule_start_state>(*atn, i));
+				stop_states.push_back(add_state<rule_stop_state>(*atn, i));
+			}
+
+			for (size_t i = 0; i < rule_count; i++)
+			{
+				std::shared_ptr<star_loop_entry_state> entry = add_state<star_loop_entry_state>(*atn, i);
+				std::shared_ptr<star_block_start_state> block_start = add_state<star_block_start_state>(*atn, i);
+				std::shared_ptr<basic_state> match = add_state<basic_state>(*atn, i);
+				std::shared_ptr<block_end_state> block_end = add_state<block_end_state>(*atn, i);
+				std::shared_ptr<star_loopback_state> loopback = add_state<star_loopback_state>(*atn, i);
+				std::shared_ptr<loop_end_state> loop_end = add_state<loop_end_state>(*atn, i);
+				block_start->end_state(block_end);
+				loop_end->loopback_state(loopback);
+				atn->add_decision_state(entry);
+				atn->add_decision_state(block_start);
+
+				atn->rule_start_states()[i]->add_transition(std::make_shared<epsilon_transition>(entry, -1));
+				entry->add_transition(std::make_shared<epsilon_transition>(block_start, -1));
+				entry->add_transition(std::make_shared<epsilon_transition>(loop_end, -1));
+				block_start->add_transition(std::make_shared<epsilon_transition>(match, -1));
+				match->add_transition(std::make_shared<atom_transition>(block_end, 1));
+				block_end->add_transition(std::make_shared<epsilon_transition>(loopback, -1));
+				loopback->add_transition(std::make_shared<epsilon_transition>(entry, -1));
+				if (i + 1 == rule_count)
+				{
+					loop_end->add_transition(std::make_shared<epsilon_transition>(stop_states[i], -1));
+					continue;
+				}
+
+				std::shared_ptr<basic_state> call = add_state<basic_state>(*atn, i);
+				std::shared_ptr<basic_state> follow = add_state<basic_state>(*atn, i);
+				loop_end->add_transition(std::make_shared<epsilon_transition>(call, -1));
+				call->add_transition(std::make_shared<rule_transition>(atn->rule_start_states()[i + 1], i + 1, 0, follow));
+				follow->add_transition(std::make_shared<epsilon_transition>(stop_states[i], -1));
+			}
+
+			return atn;
+		}
+
+		// e[p] : INT ({precpred(2)}? '*' e[3])* ;  with INT = 1 and '*' = 2, in the form of a rewritten left-recursive rule
+		std::shared_ptr<grammar_atn> create_precedence_atn()
+		{
+			std::shared_ptr<grammar_atn> atn = std::make_shared<grammar_atn>(atn_type::parser, 2);
+			std::shared_ptr<rule_start_state> start = add_rule(*atn);
+			start->precedence_rule(true);
+
+			std::shared_ptr<basic_state> primary = add_state<basic_state>(*atn);
+			std::shared_ptr<star_loop_entry_state> entry = add_state<star_loop_entry_state>(*atn);
+			std::shared_ptr<star_block_start_state> block_start = add_state<star_block_start_state>(*atn);
+			std::shared_ptr<basic_state> predicate = add_state<basic_state>(*atn);
+			std::shared_ptr<basic_state> op = add_state<basic_state>(*atn);
+			std::shared_ptr<basic_state> call = add_state<basic_state>(*atn);
+			std::shared_ptr<basic_state> follow = add_state<basic_state>(*atn);
+			std::shared_ptr<block_end_state> block_end = add_state<block_end_state>(*atn);
+			std::shared_ptr<star_loopback_state> loopback = add_state<star_loopback_state>(*atn);
+			std::shared_ptr<loop_end_state> loop_end = add_state<loop_end_state>(*atn);
+			entry->precedence_rule_decision(true);
+			entry->loopback_state(loopback);
+			block_start->end_state(block_end);
+			block_end->start_state(block_start);
+			loop_end->loopback_state(loopback);
+			atn->add_decision_state(entry);
+			atn->add_decision_state(block_start);
+
+			start->add_transition(std::make_shared<epsilon_transition>(primary, -1));
+			primary->add_transition(std::make_shared<atom_transition>(entry, 1));
+			entry->add_transition(std::make_shared<epsilon_transition>(block_start, -1));
+			entry->add_transition(std::make_shared<epsilon_transition>(loop_end, -1));
+			block_start->add_transition(std::make_shared<epsilon_transition>(predicate, -1));
+			predicate->add_transition(std::make_shared<precedence_transition>(op, 2));
+			op->add_transition(std::make_shared<atom_transition>(call, 2));
+			call->add_transition(std::make_shared<rule_transition>(start, 0, 3, follow));
+			follow->add_transition(std::make_shared<epsilon_transition>(block_end, -1));
+			block_end->add_transition(std::make_shared<epsilon_transition>(loopback, -1));
+			loopback->add_transition(std::make_shared<epsilon_transition>(entry, -1));
+			loop_end->add_transition(std::make_shared<epsilon_transition>(start->stop_state(), -1));
+			start->stop_state()->add_transition(std::make_shared<epsilon_transition>(follow, -1));
+			return atn;
+		}
+
+		std::string process_and_write(grammar_atn& atn, atn_deserialization_options const& options, size_t thread_count)
+		{
+			atn_post_processor::process(atn, options, thread_count);
+			atn.build_transition_table();
+			std::ostringstream out;
+			static_atn_writer::write(out, "atn", atn, std::vector<std::shared_ptr<antlr4::atn::lexer_action>>());
+			return out.str();
+		}
+
+		atn_deserialization_options only(bool inline_trivial_rules, bool collapse_epsilon_chains, bool merge_sets, bool mark_tail_calls)
+		{
+			atn_deserialization_options options;
+			options.inline_trivial_rules(inline_trivial_rules);
+			options.collapse_epsilon_chains(collapse_epsilon_chains);
+			options.merge_sets(merge_sets);
+			options.mark_tail_calls(mark_tail_calls);
+			return options;
+		}
+
+		// ------------ TESTS -------------------------
+
+		void test_transition_table()
+		{
+			grammar_atn atn(atn_type::lexer, 127);
+			std::shared_ptr<basic_state> s0 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s1 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s2 = add_state<basic_state>(atn);
+			s0->add_transition(std::make_shared<atom_transition>(s1, 'a'));
+			s0->add_transition(std::make_shared<range_transition>(s2, std::make_pair<int32_t, int32_t>('0', '9' + 1)));
+			s1->add_transition(std::make_shared<epsilon_transition>(s2, -1));
+
+			atn.build_transition_table();
+			assert(atn.transition_table()->state_count() == 3);
+			assert(atn.transition_table()->size() == 3);
+			assert(atn.alternative_table() == atn.transition_table());
+
+			transition_table::view transitions = s0->transition_view();
+			assert(transitions.size() == 2);
+			assert(transitions[0].type == transition::transition_type::atom && transitions[0].target == 1);
+			assert(transitions[0].first == 'a' && transitions[0].second == 'a' + 1);
+			assert(transitions[1].type == transition::transition_type::range && transitions[1].target == 2);
+			assert(transitions[1].first == '0' && transitions[1].second == '9' + 1);
+			assert(transitions[1].flags == 0 && transitions[1].reserved == 0);
+
+			assert(s1->transition_view().size() == 1 && s1->transition_view()[0].type == transition::transition_type::epsilon);
+			assert(s2->transition_view().empty());
+		}
+
+		void test_transition_types()
+		{
+			std::shared_ptr<basic_state> target = std::make_shared<basic_state>(0, 0);
+			assert(wildcard_transition(target).type() == transition::transition_type::wildcard);
+			assert(precedence_transition(target, 2).type() == transition::transition_type::precedence);
+			assert(precedence_transition(target, 2).epsilon());
+			assert(!wildcard_transition(target).epsilon());
+
+			assert(atom_transition(target, 'a').matches('a', 0, 127));
+			assert(!atom_transition(target, 'a').matches('b', 0, 127));
+			assert(range_transition(target, std::make_pair<int32_t, int32_t>('a', 'z' + 1)).matches('z', 0, 127));
+			assert(!range_transition(target, std::make_pair<int32_t, int32_t>('a', 'z' + 1)).matches('z' + 1, 0, 127));
+			assert(wildcard_transition(target).matches(127, 0, 127));
+			assert(!wildcard_transition(target).matches(128, 0, 127));
+			assert(!epsilon_transition(target, -1).matches(0, 0, 127));
+		}
+
+		void test_set_transitions()
+		{
+			std::shared_ptr<basic_state> target = std::make_shared<basic_state>(0, 0);
+			std::shared_ptr<antlr4::misc::interval_set<int32_t>> label = std::make_shared<antlr4::misc::interval_set<int32_t>>();
+			label->insert(std::make_pair<int32_t, int32_t>('a', 'z' + 1));
+			label->insert('_');
+			label->insert(0x3B1);
+
+			set_transition set(target, label);
+			assert(set.type() == transition::transition_type::set);
+			assert(!set.epsilon());
+			assert(set.matches('a', 0, 0xFFFF) && set.matches('z', 0, 0xFFFF) && set.matches('_', 0, 0xFFFF));
+			assert(!set.matches('A', 0, 0xFFFF) && !set.matches('z' + 1, 0, 0xFFFF) && !set.matches(-1, 0, 0xFFFF));
+			assert(set.matches(0x3B1, 0, 0xFFFF) && !set.matches(0x3B2, 0, 0xFFFF));
+
+			not_set_transition not_set(target, label, 0, 0xFFFF);
+			assert(not_set.type() == transition::transition_type::not_set);
+			assert(&not_set.label() == label.get());
+			assert(!not_set.matches('a', 0, 0xFFFF) && !not_set.matches('_', 0, 0xFFFF) && !not_set.matches(0x3B1, 0, 0xFFFF));
+			assert(not_set.matches('A', 0, 0xFFFF) && not_set.matches(0, 0, 0xFFFF) && not_set.matches(0x3B2, 0, 0xFFFF));
+			assert(!not_set.matches(-1, 0, 0xFFFF) && !not_set.matches(0x10000, 0, 0xFFFF));
+		}
+
+		void test_next_states()
+		{
+			grammar_atn atn(atn_type::lexer, 127);
+			std::shared_ptr<basic_state> s0 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s1 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s2 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s3 = add_state<basic_state>(atn);
+			s0->add_transition(std::make_shared<atom_transition>(s1, 'a'));
+			s0->add_transition(std::make_shared<range_transition>(s2, std::make_pair<int32_t, int32_t>('a', 'z' + 1)));
+			s0->add_transition(std::make_shared<wildcard_transition>(s3));
+			s1->add_transition(std::make_shared<not_set_transition>(s2, std::make_shared<antlr4::misc::interval_set<int32_t>>(antlr4::misc::interval_set<int32_t>::of('a')), 0, 127));
+			atn.build_transition_table();
+
+			std::vector<uint32_t> states;
+			atn.transition_table()->next_states(0, 'a', 0, 127, states);
+			assert(states == (std::vector<uint32_t> { 1, 2, 3 }));
+
+			states.clear();
+			atn.transition_table()->next_states(0, 'q', 0, 127, states);
+			assert(states == (std::vector<uint32_t> { 2, 3 }));
+
+			states.clear();
+			atn.transition_table()->next_states(0, '0', 0, 127, states);
+			assert(states == std::vector<uint32_t> { 3 });
+
+			states.clear();
+			atn.transition_table()->next_states(1, 'a', 0, 127, states);
+			atn.transition_table()->next_states(1, 'b', 0, 127, states);
+			assert(states == std::vector<uint32_t> { 2 });
+		}
+
+		void test_inline_trivial_rules()
+		{
+			// r0 : r1 ; r1 : 'x' ;
+			grammar_atn atn(atn_type::parser, 3);
+			std::shared_ptr<rule_start_state> r0 = add_rule(atn);
+			std::shared_ptr<rule_start_state> r1 = add_rule(atn);
+			std::shared_ptr<basic_state> call = add_state<basic_state>(atn, 0);
+			std::shared_ptr<basic_state> follow = add_state<basic_state>(atn, 0);
+			std::shared_ptr<basic_state> match = add_state<basic_state>(atn, 1);
+			std::shared_ptr<basic_state> matched = add_state<basic_state>(atn, 1);
+			r0->add_transition(std::make_shared<epsilon_transition>(call, -1));
+			call->add_transition(std::make_shared<rule_transition>(r1, 1, 0, follow));
+			follow->add_transition(std::make_shared<epsilon_transition>(r0->stop_state(), -1));
+			r1->add_transition(std::make_shared<epsilon_transition>(match, -1));
+			match->add_transition(std::make_shared<atom_transition>(matched, 'x'));
+			matched->add_transition(std::make_shared<epsilon_transition>(r1->stop_state(), -1));
+			r1->stop_state()->add_transition(std::make_shared<epsilon_transition>(follow, -1));
+
+			atn_optimizer::statistics statistics = atn_optimizer::optimize(atn, only(true, false, false, true));
+			assert(statistics.inline_trivial_rules.optimizations == 1);
+			assert(statistics.inline_trivial_rules.removed_states == -1);
+			assert(statistics.inline_trivial_rules.removed_transitions == -1);
+			assert(statistics.collapse_epsilon_chains.optimizations == 0);
+
+			// the call is replaced by an epsilon transition to a state matching 'x' directly
+			assert(call->transition(0)->type() == transition::transition_type::rule);
+			assert(call->optimized_transitions().size() == 1 && call->optimized_transition(0)->type() == transition::transition_type::epsilon);
+			std::shared_ptr<atn_state> inlined = call->optimized_transition(0)->target();
+			assert(inlined->transition(0)->type() == transition::transition_type::atom);
+			assert(inlined->transition(0)->target() == follow);
+
+			// only epsilon transitions lead from the follow state to the end of r0
+			assert(statistics.mark_tail_calls.optimizations == 1);
+			assert(static_cast<rule_transition const&>(*call->transition(0)).tail_call());
+			assert(static_cast<rule_transition const&>(*call->transition(0)).optimized_tail_call());
+		}
+
+		void test_collapse_epsilon_chains()
+		{
+			grammar_atn atn(atn_type::parser, 3);
+			std::shared_ptr<rule_start_state> r0 = add_rule(atn);
+			std::shared_ptr<basic_state> a = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> b = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> c = add_state<basic_state>(atn);
+			r0->add_transition(std::make_shared<epsilon_transition>(a, -1));
+			a->add_transition(std::make_shared<epsilon_transition>(b, -1));
+			b->add_transition(std::make_shared<epsilon_transition>(c, -1));
+			c->add_transition(std::make_shared<atom_transition>(r0->stop_state(), 1));
+
+			atn_optimizer::statistics statistics = atn_optimizer::optimize(atn, only(false, true, false, false));
+			assert(statistics.collapse_epsilon_chains.optimizations == 3);
+			assert(statistics.collapse_epsilon_chains.removed_states == 2);
+			assert(statistics.collapse_epsilon_chains.removed_transitions == 2);
+			assert(r0->optimized_transitions().size() == 1 && r0->optimized_transition(0)->target() == c);
+			assert(r0->transition(0)->target() == a);
+
+			// nothing is done unless optimize is set
+			grammar_atn unoptimized(atn_type::parser, 3);
+			std::shared_ptr<rule_start_state> start = add_rule(unoptimized);
+			std::shared_ptr<basic_state> d = add_state<basic_state>(unoptimized);
+			start->add_transition(std::make_shared<epsilon_transition>(d, -1));
+			d->add_transition(std::make_shared<epsilon_transition>(start->stop_state(), -1));
+			atn_deserialization_options options;
+			options.optimize(false);
+			assert(atn_optimizer::optimize(unoptimized, options).collapse_epsilon_chains.optimizations == 0);
+			assert(!start->optimized());
+		}
+
+		void test_merge_sets()
+		{
+			grammar_atn atn(atn_type::parser, 10);
+			std::shared_ptr<rule_start_state> r0 = add_rule(atn);
+			std::shared_ptr<basic_block_start_state> block_start = add_state<basic_block_start_state>(atn);
+			std::shared_ptr<block_end_state> block_end = add_state<block_end_state>(atn);
+			block_start->end_state(block_end);
+			block_end->start_state(block_start);
+			r0->add_transition(std::make_shared<epsilon_transition>(block_start, -1));
+			block_end->add_transition(std::make_shared<epsilon_transition>(r0->stop_state(), -1));
+
+			std::shared_ptr<basic_state> alt1 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> alt2 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> alt3 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> after3 = add_state<basic_state>(atn);
+			block_start->add_transition(std::make_shared<epsilon_transition>(alt1, -1));
+			block_start->add_transition(std::make_shared<epsilon_transition>(alt2, -1));
+			block_start->add_transition(std::make_shared<epsilon_transition>(alt3, -1));
+			alt1->add_transition(std::make_shared<atom_transition>(block_end, 1));
+			alt2->add_transition(std::make_shared<range_transition>(block_end, std::make_pair<int32_t, int32_t>(3, 5)));
+			alt3->add_transition(std::make_shared<atom_transition>(after3, 9));
+			after3->add_transition(std::make_shared<epsilon_transition>(block_end, -1));
+
+			atn_optimizer::statistics statistics = atn_optimizer::optimize(atn, only(false, false, true, false));
+			assert(statistics.merge_sets.optimizations == 1);
+			assert(statistics.merge_sets.removed_states == 1);
+			assert(statistics.merge_sets.removed_transitions == 2);
+
+			assert(block_start->optimized_transitions().size() == 2);
+			assert(block_start->optimized_transition(0)->target() == alt3);
+			transition const& merged = *block_start->optimized_transition(1)->target()->transition(0);
+			assert(merged.type() == transition::transition_type::set && merged.target() == block_end);
+			assert(merged.matches(1, 1, 10) && !merged.matches(2, 1, 10) && merged.matches(3, 1, 10) && merged.matches(4, 1, 10) && !merged.matches(5, 1, 10));
+
+			// the order of lexer alternatives is significant, so they are not merged
+			grammar_atn lexer_atn(atn_type::lexer, 127);
+			assert(atn_optimizer::merge_sets(lexer_atn) == 0);
+		}
+
+		void test_epsilon_closure_table()
+		{
+			grammar_atn atn(atn_type::parser, 3);
+			std::shared_ptr<rule_start_state> r0 = add_rule(atn);
+			std::shared_ptr<basic_state> s2 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s3 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s4 = add_state<basic_state>(atn);
+			std::shared_ptr<basic_state> s5 = add_state<basic_state>(atn);
+			r0->add_transition(std::make_shared<epsilon_transition>(s2, -1));
+			r0->add_transition(std::make_shared<epsilon_transition>(s4, -1));
+			r0->add_transition(std::make_shared<epsilon_transition>(r0->stop_state(), -1));
+			s2->add_transition(std::make_shared<epsilon_transition>(s3, -1));
+			s3->add_transition(std::make_shared<atom_transition>(s5, 1));
+			s4->add_transition(std::make_shared<predicate_transition>(s3, 0, 0, false));
+			s5->add_transition(std::make_shared<epsilon_transition>(s3, -1));
+
+			atn.build_transition_table();
+			epsilon_closure_table table(atn);
+			epsilon_closure_table::view closure = table.closure(0);
+			assert(closure.size() == 3);
+			assert(closure[0].state == 3 && !closure[0].context_sensitive);
+			assert(closure[1].state == 4 && closure[1].context_sensitive);
+			assert(closure[2].state == 1 && closure[2].context_sensitive);
+			assert(!table.context_free(0));
+
+			assert(table.closure(2).size() == 1 && table.closure(2)[0].state == 3);
+			assert(table.context_free(2));
+			assert(table.closure(3).size() == 1 && table.closure(3)[0].state == 3);
+			assert(table.closure(5).size() == 1 && table.closure(5)[0].state == 3);
+		}
+
+		void test_ll1_analysis()
+		{
+			std::shared_ptr<grammar_atn> atn = create_decision_atn();
+			atn->build_transition_table();
+			ll1_analyzer analyzer(*atn);
+
+			bool predicated = false;
+			std::vector<antlr4::misc::interval_set<int32_t>> lookahead = analyzer.decision_lookahead(*atn->decision_states()[0], predicated);
+			assert(!predicated);
+			assert(lookahead.size() == 3);
+			assert(lookahead[0] == antlr4::misc::interval_set<int32_t>::of(1));
+			assert(lookahead[1] == antlr4::misc::interval_set<int32_t>::of(2));
+
+			// the empty alternative is followed by what follows r0 where it is invoked, or by EOF
+			antlr4::misc::interval_set<int32_t> follow = antlr4::misc::interval_set<int32_t>::of(3);
+			follow.insert(antlr4::token::eof);
+			assert(lookahead[2] == follow);
+
+			analyzer.decision_lookahead(*atn->decision_states()[2], predicated);
+			assert(predicated);
+
+			ll1_decision_table table(*atn);
+			assert(table.ll1_decisions() == 1);
+			assert(table.ll1(0) && !table.ll1(1) && !table.ll1(2));
+			assert(table.predict(0, 1) == 1);
+			assert(table.predict(0, 2) == 2);
+			assert(table.predict(0, 3) == 3);
+			assert(table.predict(0, antlr4::token::eof) == 3);
+			assert(table.predict(0, 4) == ll1_decision_table::invalid_alternative);
+			assert(table.predict(0, 5) == ll1_decision_table::invalid_alternative);
+		}
+
+		void test_lookahead_table()
+		{
+			std::shared_ptr<grammar_atn> atn = create_decision_atn();
+			atn->build_transition_table();
+			lookahead_table table(*atn, 3);
+			assert(table.fixed(0) && table.depth(0) == 1);
+			assert(!table.fixed(1) && !table.fixed(2));
+			assert(table.predict(0, constant<2>) == 2);
+			assert(table.predict(0, constant<antlr4::token::eof>) == 3);
+
+			// r0 : (A B | A C | D) ;
+			grammar_atn llk(atn_type::parser, 4);
+			std::shared_ptr<rule_start_state> r0 = add_rule(llk);
+			auto block = add_block(llk, 0, std::vector<make_transition> { &match<1>, &match<1>, &match<4> });
+			r0->add_transition(std::make_shared<epsilon_transition>(block.first, -1));
+			block.second->add_transition(std::make_shared<epsilon_transition>(r0->stop_state(), -1));
+			for (size_t i = 0; i < 2; i++)
+			{
+				std::shared_ptr<atn_state> alternative = block.first->transition(i)->target();
+				std::shared_ptr<basic_state> second = add_state<basic_state>(llk);
+				second->add_transition(std::make_shared<atom_transition>(block.second, static_cast<int32_t>(2 + i)));
+				alternative->set_transition(0, std::make_shared<atom_transition>(second, 1));
+			}
+
+			llk.build_transition_table();
+			assert(!lookahead_table(llk, 1).fixed(0));
+
+			lookahead_table llk_table(llk, 2);
+			assert(llk_table.fixed(0) && llk_table.depth(0) == 2);
+			assert(llk_table.row_count() == 2);
+
+			// a decision needing more rows than allowed leaves none behind
+			lookahead_table budget(llk, 2, 1);
+			assert(!budget.fixed(0) && budget.row_count() == 0);
+			assert(lookahead_table(*atn, 3, 1).fixed(0));
+
+			int32_t input[][2] = { { 1, 2 }, { 1, 3 }, { 4, 4 }, { 1, 1 }, { 2, 2 } };
+			size_t expected[] = { 1, 2, 3, lookahead_table::invalid_alternative, lookahead_table::invalid_alternative };
+			for (size_t i = 0; i < 5; i++)
+			{
+				size_t predicted = llk_table.predict(0,
+					[&](size_t k)
+					{
+						return input[i][k - 1];
+					});
+				assert(predicted == expected[i]);
+			}
+		}
+
+		void test_static_atn()
+		{
+			std::unique_ptr<grammar_atn> atn = static_lexer.instantiate();
+			assert(atn->grammar_type() == atn_type::lexer && atn->states().size() == 6);
+			assert(atn->rule_start_states().size() == 1);
+			assert(atn->rule_start_states()[0]->stop_state() == atn->state(1));
+			assert(atn->decision_states().size() == 1 && atn->decision_states()[0]->decision() == 0);
+			assert(std::static_pointer_cast<block_end_state>(atn->state(3))->start_state() == atn->state(2));
+
+			// the states have no transition objects, and view the static arrays directly
+			assert(atn->state(2)->transitions().empty());
+			assert(atn->state(2)->transition_view().begin() == &static_lexer_transitions[1]);
+			assert(atn->state(2)->only_has_epsilon_transitions());
+			assert(!atn->state(4)->only_has_epsilon_transitions());
+
+			std::vector<uint32_t> states;
+			atn->transition_table()->next_states(4, 'b', 0, 127, states);
+			atn->transition_table()->next_states(4, 'y', 0, 127, states);
+			atn->transition_table()->next_states(4, 'd', 0, 127, states);
+			atn->transition_table()->next_states(5, '0', 0, 127, states);
+			assert(states == std::vector<uint32_t>({ 3, 3, 3 }));
+
+			std::vector<std::shared_ptr<antlr4::atn::lexer_action>> lexer_actions;
+			lexer_actions.push_back(std::make_shared<antlr4::atn::lexer_action::channel_action>(2));
+			lexer_actions.push_back(std::make_shared<antlr4::atn::lexer_action::custom_action>(0, 5));
+
+			std::ostringstream out;
+			static_atn_writer::write(out, "static_lexer", *atn, lexer_actions);
+			std::string source = out.str();
+			assert(source.find("\t\t{ antlr4::atn::atn_state::atn_state_type::block_start, 0u, 3u, 4294967295u, 0u },\n") != std::string::npos);
+			assert(source.find("\tconst uint32_t static_lexer_transition_offsets[] =\n\t{\n\t\t0u,\n\t\t1u,\n") != std::string::npos);
+			assert(source.find("\t\t{ antlr4::atn::transition::transition_type::set, 0u, 0, 3u, 0, 2 },\n") != std::string::npos);
+			assert(source.find("\t\t{ 120, 123 },\n") != std::string::npos);
+			assert(source.find("\t\t{ antlr4::atn::lexer_action::lexer_action_type::custom, 5 },\n") != std::string::npos);
+			assert(source.find("extern const antlr4::atn::static_atn static_lexer =\n{\n\tantlr4::atn::atn_type::lexer,\n\t127,\n\t6,\n\tstatic_lexer_states,\n") != std::string::npos);
+
+			// an ATN built from transition objects describes its operands the same way
+			std::shared_ptr<grammar_atn> decision_atn = create_decision_atn();
+			decision_atn->build_transition_table();
+			std::ostringstream decision_out;
+			static_atn_writer::write(decision_out, "decision_atn", *decision_atn, std::vector<std::shared_ptr<antlr4::atn::lexer_action>>());
+			std::string decision_source = decision_out.str();
+			assert(decision_source.find("\t\t{ antlr4::atn::transition::transition_type::rule, 0u, 0, 0u, 16, 0 },\n") != std::string::npos);
+			assert(decision_source.find("\t\t{ antlr4::atn::transition::transition_type::predicate, 0u, 0, 18u, 0, 0 },\n") != std::string::npos);
+			assert(decision_source.find("\tnullptr,\n};\n") != std::string::npos);
+		}
+
+		void test_static_atn_analysis()
+		{
+			std::unique_ptr<grammar_atn> lexer_atn = static_lexer.instantiate();
+			epsilon_closure_table closures(*lexer_atn);
+			epsilon_closure_table::view closure = closures.closure(0);
+			assert(closure.size() == 2);
+			assert(closure[0].state == 4 && closure[1].state == 5);
+
+			std::unique_ptr<grammar_atn> atn = static_parser.instantiate();
+
+			// the analyses walk the transition tables, so no transition objects are created
+			assert(atn->state(5)->transitions().empty());
+
+			ll1_decision_table ll1_table(*atn);
+			assert(ll1_table.ll1(0));
+			assert(ll1_table.predict(0, 1) == 1);
+			assert(ll1_table.predict(0, 2) == 2);
+
+			lookahead_table table(*atn, 1);
+			assert(table.fixed(0));
+			assert(table.predict(0, constant<1>) == 1);
+			assert(table.predict(0, constant<2>) == 2);
+		}
+
+		void test_static_atn_round_trip()
+		{
+			std::shared_ptr<grammar_atn> merged = create_merged_atn();
+			grammar_atn& atn = *merged;
+			std::shared_ptr<rule_start_state> r0 = atn.rule_start_states()[0];
+			std::shared_ptr<decision_state> block_start = atn.decision_states()[0];
+
+			std::string source = process_and_write(atn, atn_deserialization_options(), 1);
+			assert(block_start->optimized());
+			assert(atn.alternative_table() != atn.transition_table());
+			assert(source.find("\tconst antlr4::atn::transition_table::entry atn_alternative_transitions[] =\n") != std::string::npos);
+			assert(source.find("\tatn_alternative_transition_offsets,\n\tatn_alternative_transitions,\n") != std::string::npos);
+
+			// a static_atn over the arrays the writer emitted
+			std::vector<static_atn::state> states;
+			for each (std::shared_ptr<atn_state> const& state in atn.states())
+			{
+				states.push_back(static_atn::describe(*state));
+			}
+
+			std::vector<uint32_t> rule_start_states(1, static_cast<uint32_t>(r0->state_number()));
+			std::vector<uint32_t> decision_states(1, static_cast<uint32_t>(block_start->state_number()));
+			transition_table const& table = *atn.transition_table();
+			transition_table const& alternatives = *atn.alternative_table();
+			const static_atn written =
+			{
+				atn.grammar_type(),
+				atn.max_token_type(),
+				states.size(),
+				states.data(),
+				table.offsets(),
+				table.entries(),
+				table.interval_count(),
+				table.intervals(),
+				alternatives.offsets(),
+				alternatives.entries(),
+				alternatives.interval_count(),
+				alternatives.intervals(),
+				rule_start_states.size(),
+				rule_start_states.data(),
+				decision_states.size(),
+				decision_states.data(),
+				0,
+				nullptr,
+			};
+
+			std::unique_ptr<grammar_atn> instantiated = written.instantiate();
+			ll1_decision_table source_table(atn);
+			ll1_decision_table static_table(*instantiated);
+			assert(source_table.predict(0, 1) == 1 && source_table.predict(0, 2) == 2 && source_table.predict(0, 4) == 3);
+			for (int32_t token = 1; token <= 4; token++)
+			{
+				assert(static_table.predict(0, token) == source_table.predict(0, token));
+			}
+
+			lookahead_table static_lookahead(*instantiated, 1);
+			assert(static_lookahead.predict(0, constant<1>) == 1);
+			assert(static_lookahead.predict(0, constant<2>) == 2);
+			assert(static_lookahead.predict(0, constant<4>) == 3);
+		}
+
+		void test_binary_atn()
+		{
+			std::shared_ptr<grammar_atn> source = create_decision_atn();
+			size_t size;
+			std::vector<uint64_t> image = write_image(*source, size);
+
+			binary_atn atn(image.data(), size);
+			assert(atn.arrays().state_count == source->states().size());
+
+			// the image holds no pointers or padding, so writing the same grammar again gives the same bytes
+			size_t rewritten_size;
+			assert(write_image(*create_decision_atn(), rewritten_size) == image && rewritten_size == size);
+			assert(!atn.materialized(0) && !atn.materialized(1) && !atn.materialized(2));
+			assert(!atn.atn().state(0) && !atn.atn().state(11));
+
+			// entering r1 creates its states only, and registers its decision
+			std::shared_ptr<rule_start_state> r1 = atn.enter_rule(1);
+			assert(r1 && r1->state_number() == 2 && r1->stop_state() == atn.atn().state(3));
+			assert(atn.materialized(1) && !atn.materialized(0));
+			assert(atn.atn().decision_states()[1] == atn.atn().state(11) && atn.atn().decision_states()[1]->decision() == 1);
+			assert(!atn.atn().decision_states()[0] && !atn.atn().state(0));
+			assert(std::static_pointer_cast<block_end_state>(atn.atn().state(12))->start_state() == atn.atn().state(11));
+
+			// the rule transition out of r1 is viewed in the image, and leads into r0 once it is entered
+			transition_table::entry const& call = atn.atn().state(15)->transition_view()[0];
+			assert(call.type == transition::transition_type::rule && call.target == 0 && call.first == 16);
+			assert(atn.enter_rule(atn.arrays().states[call.target].rule_index) == atn.atn().state(0));
+			assert(atn.atn().state(0)->only_has_epsilon_transitions());
+			assert(atn.enter_rule(1) == r1);
+
+			image[0] ^= 1;
+			bool rejected = false;
+			try
+			{
+				binary_atn other(image.data(), size);
+			}
+			catch (std::invalid_argument const&)
+			{
+				rejected = true;
+			}
+
+			assert(rejected);
+
+			image[0] ^= 1;
+			rejected = false;
+			try
+			{
+				binary_atn other(image.data(), size - sizeof(uint64_t));
+			}
+			catch (std::invalid_argument const&)
+			{
+				rejected = true;
+			}
+
+			assert(rejected);
+		}
+
+		void test_binary_atn_rule_less_states()
+		{
+			// r0 : [a-c] ; entered from the start state of the default mode, which belongs to no rule
+			grammar_atn source(atn_type::lexer, 127);
+			std::shared_ptr<rule_start_state> r0 = add_rule(source);
+			std::shared_ptr<basic_state> s2 = add_state<basic_state>(source);
+			std::shared_ptr<tokens_start_state> mode = add_state<tokens_start_state>(source, ~static_cast<size_t>(0));
+			r0->add_transition(std::make_shared<epsilon_transition>(s2, -1));
+			s2->add_transition(std::make_shared<set_transition>(r0->stop_state(), std::make_shared<antlr4::misc::interval_set<int32_t>>(antlr4::misc::interval_set<int32_t>::of(std::make_pair('a', 'c' + 1)))));
+			mode->add_transition(std::make_shared<epsilon_transition>(r0, -1));
+			source.add_decision_state(mode);
+
+			size_t size;
+			std::vector<uint64_t> image = write_image(source, size);
+			binary_atn atn(image.data(), size);
+
+			// the mode start state is created with the binary_atn, and the rules only once entered
+			assert(atn.atn().state(3) && atn.atn().state(3)->state_type() == atn_state::atn_state_type::token_start);
+			assert(atn.atn().decision_states()[0] == atn.atn().state(3));
+			assert(atn.atn().state(3)->transition_view()[0].target == 0);
+			assert(!atn.materialized(0) && !atn.atn().state(0));
+			assert(atn.enter_rule(0) == atn.atn().state(0));
+		}
+
+		void test_binary_atn_alternatives()
+		{
+			// the image keeps the unoptimized transitions, so the alternatives of a decision keep their numbers
+			std::shared_ptr<grammar_atn> source = create_merged_atn();
+			atn_post_processor::process(*source, atn_deserialization_options(), 1);
+			size_t size;
+			std::vector<uint64_t> image = write_image(*source, size);
+			binary_atn atn(image.data(), size);
+			assert(atn.arrays().alternative_transition_offsets);
+			assert(atn.atn().alternative_table() != atn.atn().transition_table());
+
+			atn.enter_rule(0);
+			ll1_decision_table source_table(*source);
+			ll1_decision_table binary_table(atn.atn());
+			assert(binary_table.predict(0, 1) == 1 && binary_table.predict(0, 2) == 2 && binary_table.predict(0, 4) == 3);
+			for (int32_t token = 1; token <= 4; token++)
+			{
+				assert(binary_table.predict(0, token) == source_table.predict(0, token));
+			}
+
+			assert(rejects(image, size, &atn.arrays().alternative_transitions[0].target, static_cast<uint32_t>(atn.arrays().state_count)));
+
+			// an image of an unoptimized ATN has no alternatives section
+			size_t decision_size;
+			std::vector<uint64_t> decision_image = write_image(*create_decision_atn(), decision_size);
+			binary_atn decision_atn(decision_image.data(), decision_size);
+			assert(!decision_atn.arrays().alternative_transition_offsets);
+			assert(decision_atn.atn().alternative_table() == decision_atn.atn().transition_table());
+
+			// r0 : A ;  r1 : r0 ; where the call to r0 is a tail call
+			grammar_atn call_source(atn_type::parser, 1);
+			std::shared_ptr<rule_start_state> r0 = add_rule(call_source);
+			std::shared_ptr<rule_start_state> r1 = add_rule(call_source);
+			r0->add_transition(match<1>(r0->stop_state()));
+			std::shared_ptr<rule_transition> call = std::make_shared<rule_transition>(r0, 0, 0, r1->stop_state());
+			call->tail_call(true);
+			call->optimized_tail_call(true);
+			r1->add_transition(call);
+			r0->stop_state()->add_transition(std::make_shared<epsilon_transition>(r1->stop_state(), -1));
+
+			size_t call_size;
+			std::vector<uint64_t> call_image = write_image(call_source, call_size);
+			binary_atn call_atn(call_image.data(), call_size);
+			transition_table::entry const& entry = call_atn.arrays().transitions[call_atn.arrays().transition_offsets[r1->state_number()]];
+			assert(entry.type == transition::transition_type::rule);
+			assert(entry.flags == (transition_table::tail_call | transition_table::optimized_tail_call));
+		}
+
+		void test_binary_atn_validation()
+		{
+			std::shared_ptr<grammar_atn> source = create_decision_atn();
+			size_t size;
+			std::vector<uint64_t> image = write_image(*source, size);
+			binary_atn atn(image.data(), size);
+			static_atn const& arrays = atn.arrays();
+			uint32_t state_count = static_cast<uint32_t>(arrays.state_count);
+			uint32_t transition_count = arrays.transition_offsets[arrays.state_count];
+
+			assert(rejects(image, size, &arrays.transitions[0].target, state_count));
+			assert(rejects(image, size, &arrays.transition_offsets[1], transition_count));
+			assert(rejects(image, size, &arrays.rule_start_states[1], state_count));
+			assert(rejects(image, size, &arrays.rule_start_states[1], arrays.rule_start_states[0]));
+			assert(rejects(image, size, &arrays.decision_states[0], state_count));
+			assert(rejects(image, size, &arrays.decision_states[0], arrays.decision_states[1]));
+			assert(rejects(image, size, &arrays.states[arrays.rule_start_states[0]].end_state, state_count));
+
+			// the follow state of the call to r0 in r1
+			transition_table::entry const& call = atn.atn().transition_table()->entries()[arrays.transition_offsets[15]];
+			assert(call.type == transition::transition_type::rule);
+			assert(rejects(image, size, &call.first, static_cast<int32_t>(state_count)));
+			assert(!rejects(image, size, &call.first, call.first));
+
+			// the intervals of a set transition
+			grammar_atn set_source(atn_type::parser, 4);
+			std::shared_ptr<rule_start_state> r0 = add_rule(set_source);
+			r0->add_transition(std::make_shared<set_transition>(r0->stop_state(), std::make_shared<antlr4::misc::interval_set<int32_t>>(antlr4::misc::interval_set<int32_t>::of(std::make_pair(1, 3)))));
+			size_t set_size;
+			std::vector<uint64_t> set_image = write_image(set_source, set_size);
+			binary_atn set_atn(set_image.data(), set_size);
+			transition_table::entry const& set = set_atn.arrays().transitions[0];
+			assert(set.type == transition::transition_type::set && set.second == 1);
+			assert(rejects(set_image, set_size, &set.second, 2));
+			assert(rejects(set_image, set_size, &set.first, -1));
+		}
+
+		void test_post_processor()
+		{
+			atn_deserialization_options options;
+			options.generate_rule_bypass_transitions(true);
+			std::string sequential = process_and_write(*create_loop_atn(16), options, 1);
+			assert(sequential == process_and_write(*create_loop_atn(16), options, 4));
+			assert(sequential == process_and_write(*create_loop_atn(16), options, 0));
+
+			std::shared_ptr<grammar_atn> atn = create_loop_atn(2);
+			atn_post_processor::process(*atn, options, 2);
+			std::shared_ptr<rule_start_state> const& r0 = atn->rule_start_states()[0];
+			std::shared_ptr<rule_start_state> const& r1 = atn->rule_start_states()[1];
+			assert(r0->stop_state() == atn->state(1) && r1->stop_state() == atn->state(3));
+
+			std::shared_ptr<star_loop_entry_state> entry = std::static_pointer_cast<star_loop_entry_state>(atn->state(4));
+			assert(entry->loopback_state() == atn->state(8));
+			assert(std::static_pointer_cast<block_end_state>(atn->state(7))->start_state() == atn->state(5));
+
+			// the call from r0 returns to its follow state
+			assert(r1->stop_state()->transitions().size() == 1 && r1->stop_state()->transition(0)->target() == atn->state(11));
+
+			// each rule is wrapped in a bypass block, numbered after the existing decisions
+			std::shared_ptr<atn_state> bypass = r1->transition(0)->target();
+			assert(bypass->state_type() == atn_state::atn_state_type::block_start);
+			assert(atn->decision_states().size() == 6 && atn->decision_states()[5] == bypass);
+			assert(bypass->transitions().size() == 2 && bypass->transition(0)->target() == atn->state(12));
+			atom_transition const& match = static_cast<atom_transition const&>(*bypass->transition(1)->target()->transition(0));
+			assert(match.label() == 4);
+
+			// the lowest numbered invalid state is reported, whichever thread finds it first
+			std::shared_ptr<grammar_atn> invalid = create_loop_atn(3);
+			options.verify_atn(false);
+			atn_post_processor::process(*invalid, options, 1);
+			std::static_pointer_cast<star_block_start_state>(invalid->state(15))->end_state(nullptr);
+			std::static_pointer_cast<star_block_start_state>(invalid->state(7))->end_state(nullptr);
+			std::string error;
+			try
+			{
+				atn_post_processor::verify(*invalid, 3);
+			}
+			catch (std::runtime_error const& e)
+			{
+				error = e.what();
+			}
+
+			assert(error == "Invalid state definition: state 7 in rule 0.");
+		}
+
+		void test_precedence_dfa()
+		{
+			using antlr4::dfa::decision_dfa;
+			using antlr4::dfa::start_configuration;
+			using antlr4::dfa::start_state;
+
+			std::shared_ptr<grammar_atn> atn = create_precedence_atn();
+			atn->build_transition_table();
+			decision_dfa loop(*atn, 0);
+			assert(loop.precedence_dfa());
+			assert(loop.start_state_count() == 0);
+
+			// up to precedence 2 the operator loop can continue at '*', or the rule can return
+			for (int32_t precedence = 0; precedence <= 2; precedence++)
+			{
+				std::vector<start_configuration> const& configurations = loop.start_state(precedence)->configurations();
+				assert(configurations.size() == 2);
+				assert(configurations[0].alternative == 1 && configurations[0].state == 6 && configurations[0].stack.empty());
+				assert(configurations[0].semantic_context == semantic_context::none);
+				assert(configurations[1].alternative == 2 && configurations[1].state == 1);
+			}
+
+			// the precedence predicate fails when e is invoked with precedence 3, so only the exit remains
+			std::shared_ptr<start_state const> exit = loop.start_state(3);
+			assert(exit->configurations().size() == 1 && exit->configurations()[0].alternative == 2);
+			assert(loop.start_state(3) == exit);
+			assert(loop.start_state_count() == 4);
+
+			// the star block decision is not a precedence decision, and keeps the predicate for prediction to evaluate
+			decision_dfa block(*atn, 1);
+			assert(!block.precedence_dfa());
+			std::shared_ptr<start_state const> block_start = block.start_state(3);
+			assert(block_start == block.start_state(0));
+			assert(block_start->configurations().size() == 1 && block_start->configurations()[0].state == 6);
+			assert(block_start->configurations()[0].semantic_context == semantic_context::precedence_predicate::instance(2));
+		}
+
+		void test_prediction_mode_tuner()
+		{
+			std::shared_ptr<grammar_atn> atn = create_decision_atn();
+			atn->build_transition_table();
+			prediction_mode_tuner tuner(*atn);
+			for (int i = 0; i < 4; i++)
+			{
+				tuner.report(0, false);
+				tuner.report(1, true);
+				tuner.report(2, i == 0);
+			}
+
+			// too few predictions to tune on, where a mode set statically is kept
+			atn->decision_states()[2]->sll(true);
+			tuner.tune(*atn, 8);
+			assert(!atn->decision_states()[0]->sll() && !atn->decision_states()[1]->ll());
+			assert(atn->decision_states()[2]->sll() && !atn->decision_states()[2]->ll());
+
+			// decision 2 sometimes falls back, so it is adaptive and keeps its static mode as well
+			tuner.tune(*atn, 4);
+			assert(atn->decision_states()[2]->sll() && !atn->decision_states()[2]->ll());
+			atn->decision_states()[2]->sll(false);
+
+			tuner.tune(*atn, 4);
+			assert(atn->decision_states()[0]->sll() && !atn->decision_states()[0]->ll());
+			assert(!atn->decision_states()[1]->sll() && atn->decision_states()[1]->ll());
+			assert(!atn->decision_states()[2]->sll() && !atn->decision_states()[2]->ll());
+
+			// a profile carries the counts to a new tuner, which tunes a fresh ATN the same way
+			std::ostringstream profile;
+			tuner.write_profile(profile);
+			prediction_mode_tuner restored(*atn);
+			std::istringstream input(profile.str());
+			restored.read_profile(input);
+			assert(restored.predictions(2) == 4 && restored.fallbacks(2) == 1);
+
+			std::shared_ptr<grammar_atn> restarted = create_decision_atn();
+			restarted->build_transition_table();
+			assert(prediction_mode_tuner::grammar_hash(*restarted) == restored.grammar_hash());
+			restored.tune(*restarted, 4);
+			assert(restarted->decision_states()[0]->sll() && restarted->decision_states()[1]->ll());
+
+			// one more conflict in decision 0 returns it to the two stage strategy
+			restored.report(0, true);
+			assert(restored.mode(0, 4) == prediction_mode_tuner::prediction_mode::adaptive);
+
+			// a grammar with as many decisions, where r2 matches A rather than B
+			std::shared_ptr<grammar_atn> edited = create_decision_atn();
+			std::shared_ptr<atn_state> alternative = edited->decision_states()[2]->transition(1)->target();
+			alternative->set_transition(0, std::make_shared<atom_transition>(alternative->transition(0)->target(), 1));
+			edited->build_transition_table();
+			assert(edited->decision_states().size() == atn->decision_states().size());
+
+			bool rejected = false;
+			try
+			{
+				prediction_mode_tuner other(*edited);
+				std::istringstream mismatched(profile.str());
+				other.read_profile(mismatched);
+			}
+			catch (std::invalid_argument const&)
+			{
+				rejected = true;
+			}
+
+			assert(rejected);
+		}
+
+		void test_atn_teardown()
+		{
+			std::weak_ptr<atn_state> start;
+			std::weak_ptr<atn_state> end;
+			{
+				grammar_atn atn(atn_type::parser, 3);
+				std::shared_ptr<basic_block_start_state> block_start = add_state<basic_block_start_state>(atn);
+				std::shared_ptr<block_end_state> block_end = add_state<block_end_state>(atn);
+				block_start->end_state(block_end);
+				block_end->start_state(block_start);
+				block_start->add_transition(std::make_shared<atom_transition>(block_end, 1));
+				block_end->add_transition(std::make_shared<epsilon_transition>(block_start, -1));
+				atn.build_transition_table();
+
+				start = block_start;
+				end = block_end;
+			}
+
+			assert(start.expired());
+			assert(end.expired());
+		}
+
+	}
+
+	void test_atn()
+	{
+		test_transition_table();
+		test_transition_types();
+		test_set_transitions();
+		test_next_states();
+		test_inline_trivial_rules();
+		test_collapse_epsilon_chains();
+		test_merge_sets();
+		test_epsilon_closure_table();
+		test_ll1_analysis();
+		test_lookahead_table();
+		test_static_atn();
+		test_static_atn_analysis();
+		test_static_atn_round_trip();
+		test_binary_atn();
+		test_binary_atn_rule_less_states();
+		test_binary_atn_alternatives();
+		test_binary_atn_validation();
+		test_post_processor();
+		test_precedence_dfa();
+		test_prediction_mode_tuner();
+		test_atn_teardown();
+	}
+
+}
+}
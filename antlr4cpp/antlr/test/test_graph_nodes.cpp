@@ -8,8 +8,12 @@
 #include <unordered_map>
 
 #include <antlr/test/test_graph_nodes.hpp>
+#include <antlr/v4/runtime/rule_context.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
 #include <antlr/v4/runtime/atn/prediction_context.hpp>
 #include <antlr/v4/runtime/atn/prediction_context_cache.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
 
 #if defined(_MSC_VER) && (_MSC_VER == 1800)
 #undef assert
@@ -40,6 +44,7 @@ namespace test {
 		std::shared_ptr<prediction_context> array(std::shared_ptr<prediction_context> const& context);
 		std::shared_ptr<prediction_context> array(std::shared_ptr<prediction_context> const& context0, std::shared_ptr<prediction_context> const& context1);
 		std::wstring to_dot_string(std::shared_ptr<prediction_context> const& context);
+		std::shared_ptr<grammar_atn> create_call_atn();
 
 		// ------------ TESTS -------------------------
 
@@ -883,8 +888,126 @@ namespace test {
 			assert(actual == expecting);
 		}
 
+		void test_append_tree_suffix()
+		{
+			// a + [x,y] -> a->[x,y]
+			std::shared_ptr<prediction_context> suffix(array(x(true), y(true)));
+			std::shared_ptr<prediction_context> r(context_cache.append_context(a(true), suffix));
+			assert(r->size() == 1 && r->return_state(0) == 1 && r->parent(0) == suffix);
+
+			// [a,$] + [x,y] -> [a->[x,y], x, y]
+			std::shared_ptr<prediction_context> optional(array(a(true), prediction_context::empty_full));
+			r = prediction_context::append_context(optional, suffix, context_cache);
+			assert(r->size() == 3);
+			assert(r->return_state(0) == 1 && r->parent(0) == suffix);
+			assert(r->return_state(1) == 9 && r->return_state(2) == 10);
+			assert(!r->has_empty());
+		}
+
+		void test_append_memo()
+		{
+			prediction_context_cache cache;
+
+			// [a,b] sharing the parent x, plus u: the shared parent is rewritten once
+			std::shared_ptr<prediction_context> shared(x(true));
+			std::shared_ptr<prediction_context> context(array(create_singleton(shared, 1), create_singleton(shared, 2)));
+			std::shared_ptr<prediction_context> r(prediction_context::append_context(context, 6, cache));
+			assert(r->size() == 2 && r->parent(0) == r->parent(1));
+			assert(r->parent(0)->return_state(0) == 9 && r->parent(0)->parent(0)->return_state(0) == 6);
+
+			// the top-level result is memoized for both overloads
+			assert(prediction_context::append_context(context, 6, cache) == r);
+			assert(prediction_context::append_context(context, cache.get_child(prediction_context::empty_full, 6), cache) == r);
+			assert(cache.append_context(context, cache.get_child(prediction_context::empty_full, 6)) == r);
+
+			// appending to a context which contains an earlier operand reuses the earlier result
+			std::shared_ptr<prediction_context> outer(create_singleton(context, 3));
+			std::shared_ptr<prediction_context> outer_result(prediction_context::append_context(outer, 6, cache));
+			assert(outer_result->return_state(0) == 3 && outer_result->parent(0) == r);
+		}
+
+		void test_from_rule_context_root()
+		{
+			std::shared_ptr<grammar_atn> atn(create_call_atn());
+			std::shared_ptr<antlr4::rule_context> root(std::make_shared<antlr4::rule_context>());
+			assert(prediction_context::from_rule_context(atn, root, true) == prediction_context::empty_full);
+			assert(prediction_context::from_rule_context(atn, root, false) == prediction_context::empty_local);
+			assert(prediction_context::from_rule_context(atn, nullptr, true) == prediction_context::empty_full);
+			assert(prediction_context::from_rule_context(atn, nullptr, false) == prediction_context::empty_local);
+		}
+
+		void test_from_rule_context_chain()
+		{
+			// r0 invokes r1 from state 4, which invokes itself from state 6
+			std::shared_ptr<grammar_atn> atn(create_call_atn());
+			std::shared_ptr<antlr4::rule_context> root(std::make_shared<antlr4::rule_context>());
+			std::shared_ptr<antlr4::rule_context> outer(std::make_shared<antlr4::rule_context>(root, 4));
+			std::shared_ptr<antlr4::rule_context> inner(std::make_shared<antlr4::rule_context>(outer, 6));
+
+			std::shared_ptr<prediction_context> full(prediction_context::from_rule_context(atn, inner, true));
+			assert(full->size() == 1 && full->return_state(0) == 7);
+			assert(full->parent(0)->size() == 1 && full->parent(0)->return_state(0) == 5);
+			assert(full->parent(0)->parent(0) == prediction_context::empty_full);
+
+			std::shared_ptr<prediction_context> local(prediction_context::from_rule_context(atn, inner, false));
+			assert(local != full);
+			assert(local->size() == 1 && local->return_state(0) == 7);
+			assert(local->parent(0)->size() == 1 && local->parent(0)->return_state(0) == 5);
+			assert(local->parent(0)->parent(0) == prediction_context::empty_local);
+		}
+
+		void test_from_rule_context_reuse()
+		{
+			std::shared_ptr<grammar_atn> atn(create_call_atn());
+			std::shared_ptr<antlr4::rule_context> root(std::make_shared<antlr4::rule_context>());
+			std::shared_ptr<antlr4::rule_context> outer(std::make_shared<antlr4::rule_context>(root, 4));
+			std::shared_ptr<antlr4::rule_context> inner(std::make_shared<antlr4::rule_context>(outer, 6));
+
+			// the chain computed for inner is recorded on each node it passed through
+			std::shared_ptr<prediction_context> full(prediction_context::from_rule_context(atn, inner, true));
+			assert(prediction_context::from_rule_context(atn, inner, true) == full);
+			assert(prediction_context::from_rule_context(atn, outer, true) == full->parent(0));
+
+			// a sibling of inner extends the context recorded on their common parent
+			std::shared_ptr<antlr4::rule_context> sibling(std::make_shared<antlr4::rule_context>(outer, 6));
+			std::shared_ptr<prediction_context> sibling_full(prediction_context::from_rule_context(atn, sibling, true));
+			assert(sibling_full != full && sibling_full->parent(0) == full->parent(0));
+
+			// the local and full chains are recorded separately
+			std::shared_ptr<prediction_context> local(prediction_context::from_rule_context(atn, outer, false));
+			assert(local != full->parent(0) && local->parent(0) == prediction_context::empty_local);
+			assert(prediction_context::from_rule_context(atn, inner, false)->parent(0) == local);
+		}
+
 		// ------------ SUPPORT -------------------------
 
+		// r0 : r1 ;  r1 : r1 | ;  with the invocation of r1 in r0 at state 4 and the one in r1 at state 6
+		std::shared_ptr<grammar_atn> create_call_atn()
+		{
+			std::shared_ptr<grammar_atn> atn(std::make_shared<grammar_atn>(atn_type::parser, 1));
+			for (size_t i = 0; i < 2; i++)
+			{
+				std::shared_ptr<rule_start_state> start(std::make_shared<rule_start_state>(atn->states().size(), i));
+				atn->add_state(start);
+				std::shared_ptr<rule_stop_state> stop(std::make_shared<rule_stop_state>(atn->states().size(), i));
+				atn->add_state(stop);
+				start->stop_state(stop);
+				atn->add_rule_start_state(start);
+			}
+
+			for (size_t i = 0; i < 2; i++)
+			{
+				std::shared_ptr<basic_state> call(std::make_shared<basic_state>(atn->states().size(), i));
+				atn->add_state(call);
+				std::shared_ptr<basic_state> follow(std::make_shared<basic_state>(atn->states().size(), i));
+				atn->add_state(follow);
+				call->add_transition(std::make_shared<rule_transition>(atn->rule_start_states()[1], 1, 0, follow));
+				follow->add_transition(std::make_shared<epsilon_transition>(atn->rule_start_states()[i]->stop_state(), -1));
+			}
+
+			return atn;
+		}
+
 		std::shared_ptr<prediction_context> a(bool fullContext) {
 			return create_singleton(fullContext ? prediction_context::empty_full : prediction_context::empty_local, 1);
 		}
@@ -1075,6 +1198,11 @@ namespace test {
 		test_Aaubv_Abwdx();
 		test_Aaubv_Abvdu();
 		test_Aaubu_Acudu();
+		test_append_tree_suffix();
+		test_append_memo();
+		test_from_rule_context_root();
+		test_from_rule_context_chain();
+		test_from_rule_context_reuse();
 	}
 
 }
@@ -289,6 +289,9 @@ namespace test {
 			assert(s.contains(55));
 			assert(s.contains(50));
 			assert(s.contains(60));
+			assert(!s.contains(16));
+			assert(!s.contains(49));
+			assert(!s.contains(61));
 		}
 
 		// {2,15,18} & 10..20
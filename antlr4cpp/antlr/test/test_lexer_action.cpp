@@ -0,0 +1,296 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "test_lexer_action.hpp"
+
+#include <antlr/v4/runtime/atn/lexer_action.hpp>
+#include <antlr/v4/runtime/atn/lexer_action_cache.hpp>
+#include <antlr/v4/runtime/atn/lexer_action_executor.hpp>
+#include <antlr/v4/runtime/atn/lexer_action_target.hpp>
+#include <antlr/v4/runtime/atn/lexer_custom_action_table.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr {
+namespace test {
+
+	using namespace antlr4::atn;
+
+	namespace {
+
+		// ------------ SUPPORT -------------------------
+
+		bool equal(std::shared_ptr<lexer_action> const& x, std::shared_ptr<lexer_action> const& y)
+		{
+			std::hash<lexer_action> hasher;
+			return *x == *y && hasher(*x) == hasher(*y);
+		}
+
+		// Records the effect of each action as a string, along with the input position custom actions observe.
+		class recording_target : public lexer_action_target
+		{
+		private:
+			size_t _index;
+
+		public:
+			std::vector<std::string> calls;
+
+		public:
+			explicit recording_target(size_t index)
+				: _index(index)
+			{
+			}
+
+		public:
+			virtual void channel(int32_t channel) override { calls.push_back("channel " + std::to_string(channel)); }
+			virtual void mode(int32_t mode) override { calls.push_back("mode " + std::to_string(mode)); }
+			virtual void more() override { calls.push_back("more"); }
+			virtual void pop_mode() override { calls.push_back("pop_mode"); }
+			virtual void push_mode(int32_t mode) override { calls.push_back("push_mode " + std::to_string(mode)); }
+			virtual void skip() override { calls.push_back("skip"); }
+			virtual void type(int32_t type) override { calls.push_back("type " + std::to_string(type)); }
+
+			virtual void action(size_t rule_index, size_t action_index) override
+			{
+				calls.push_back("action " + std::to_string(rule_index) + " " + std::to_string(action_index) + " @" + std::to_string(_index));
+			}
+
+			virtual size_t index() const override
+			{
+				return _index;
+			}
+
+			virtual void seek(size_t index) override
+			{
+				_index = index;
+			}
+		};
+
+		void table_action_0(lexer_action_target& target)
+		{
+			static_cast<recording_target&>(target).calls.push_back("table 0 @" + std::to_string(target.index()));
+		}
+
+		void table_action_1(lexer_action_target& target)
+		{
+			static_cast<recording_target&>(target).calls.push_back("table 1 @" + std::to_string(target.index()));
+		}
+
+		// ------------ TESTS -------------------------
+
+		void test_action_equality()
+		{
+			assert(equal(std::make_shared<lexer_action::channel_action>(1), std::make_shared<lexer_action::channel_action>(1)));
+			assert(!(*std::make_shared<lexer_action::channel_action>(1) == *std::make_shared<lexer_action::channel_action>(2)));
+			assert(!(*std::make_shared<lexer_action::channel_action>(1) == *std::make_shared<lexer_action::type_action>(1)));
+			assert(!(*std::make_shared<lexer_action::mode_action>(1) == *std::make_shared<lexer_action::push_mode_action>(1)));
+			assert(equal(std::make_shared<lexer_action::custom_action>(2, 3), std::make_shared<lexer_action::custom_action>(2, 3)));
+			assert(!(*std::make_shared<lexer_action::custom_action>(2, 3) == *std::make_shared<lexer_action::custom_action>(3, 2)));
+
+			std::shared_ptr<lexer_action> custom = std::make_shared<lexer_action::custom_action>(2, 3);
+			assert(equal(std::make_shared<lexer_action::indexed_custom_action>(4, custom), std::make_shared<lexer_action::indexed_custom_action>(4, std::make_shared<lexer_action::custom_action>(2, 3))));
+			assert(!(*std::make_shared<lexer_action::indexed_custom_action>(4, custom) == *std::make_shared<lexer_action::indexed_custom_action>(5, custom)));
+		}
+
+		void test_executor_equality()
+		{
+			lexer_action_executor x(std::vector<std::shared_ptr<lexer_action>> { std::make_shared<lexer_action::type_action>(3), lexer_action::skip_action::instance });
+			lexer_action_executor y(std::vector<std::shared_ptr<lexer_action>> { std::make_shared<lexer_action::type_action>(3), lexer_action::skip_action::instance });
+			lexer_action_executor z(std::vector<std::shared_ptr<lexer_action>> { std::make_shared<lexer_action::type_action>(4), lexer_action::skip_action::instance });
+			std::hash<lexer_action_executor> hasher;
+			assert(x == y && hasher(x) == hasher(y));
+			assert(!(x == z));
+		}
+
+		void test_executor_append()
+		{
+			std::shared_ptr<lexer_action_executor> type = lexer_action_executor::append(nullptr, std::make_shared<lexer_action::type_action>(3));
+			std::shared_ptr<lexer_action_executor> skip = lexer_action_executor::append(type, lexer_action::skip_action::instance);
+			assert(skip->actions().size() == 2);
+			assert(skip == lexer_action_executor::append(type, lexer_action::skip_action::instance));
+
+			// appending an equal action reuses the executor created the first time
+			std::shared_ptr<lexer_action_executor> hidden = lexer_action_executor::append(skip, std::make_shared<lexer_action::channel_action>(1));
+			assert(hidden == lexer_action_executor::append(skip, std::make_shared<lexer_action::channel_action>(1)));
+			assert(hidden != lexer_action_executor::append(skip, std::make_shared<lexer_action::channel_action>(2)));
+
+			// the incrementally computed hash matches the hash of the same actions built directly
+			lexer_action_executor direct(std::vector<std::shared_ptr<lexer_action>>(hidden->actions()));
+			std::hash<lexer_action_executor> hasher;
+			assert(*hidden == direct && hasher(*hidden) == hasher(direct));
+		}
+
+		void test_executor_execute()
+		{
+			std::shared_ptr<lexer_action> custom = std::make_shared<lexer_action::custom_action>(1, 2);
+			lexer_action_executor executor(std::vector<std::shared_ptr<lexer_action>> {
+				std::make_shared<lexer_action::type_action>(3),
+				std::make_shared<lexer_action::indexed_custom_action>(2, custom),
+				std::make_shared<lexer_action::channel_action>(1),
+				custom,
+				std::make_shared<lexer_action::push_mode_action>(4),
+				lexer_action::pop_mode_action::instance,
+				std::make_shared<lexer_action::mode_action>(5),
+				lexer_action::more_action::instance,
+				lexer_action::skip_action::instance,
+			});
+
+			recording_target target(10);
+			executor.execute(target, 6);
+			std::vector<std::string> expected {
+				"type 3",
+				"action 1 2 @8",
+				"channel 1",
+				"action 1 2 @10",
+				"push_mode 4",
+				"pop_mode",
+				"mode 5",
+				"more",
+				"skip",
+			};
+			assert(target.calls == expected);
+			assert(target.index() == 10);
+
+			// the input is restored after an indexed action which is not followed by one executed at the end of the token
+			lexer_action_executor indexed(std::vector<std::shared_ptr<lexer_action>> { std::make_shared<lexer_action::indexed_custom_action>(0, custom) });
+			recording_target indexed_target(10);
+			indexed.execute(indexed_target, 6);
+			assert(indexed_target.calls == std::vector<std::string> { "action 1 2 @6" });
+			assert(indexed_target.index() == 10);
+		}
+
+		void test_executor_net_effect()
+		{
+			lexer_action_executor executor(std::vector<std::shared_ptr<lexer_action>> {
+				std::make_shared<lexer_action::type_action>(3),
+				lexer_action::skip_action::instance,
+				std::make_shared<lexer_action::channel_action>(1),
+				std::make_shared<lexer_action::type_action>(4),
+				std::make_shared<lexer_action::push_mode_action>(1),
+				std::make_shared<lexer_action::push_mode_action>(2),
+				std::make_shared<lexer_action::mode_action>(3),
+				lexer_action::pop_mode_action::instance,
+				std::make_shared<lexer_action::mode_action>(7),
+				std::make_shared<lexer_action::channel_action>(2),
+			});
+
+			recording_target target(0);
+			executor.execute(target, 0);
+			assert(target.calls == (std::vector<std::string> { "type 4", "channel 2", "push_mode 7" }));
+
+			lexer_action_executor pops(std::vector<std::shared_ptr<lexer_action>> {
+				lexer_action::pop_mode_action::instance,
+				std::make_shared<lexer_action::mode_action>(2),
+				lexer_action::pop_mode_action::instance,
+				std::make_shared<lexer_action::push_mode_action>(5),
+				lexer_action::more_action::instance,
+			});
+
+			recording_target pops_target(0);
+			pops.execute(pops_target, 0);
+			assert(pops_target.calls == (std::vector<std::string> { "more", "pop_mode", "pop_mode", "push_mode 5" }));
+
+			// the actions of the executor are unaffected
+			assert(pops.actions().size() == 5);
+		}
+
+		void test_executor_fix_offset()
+		{
+			std::shared_ptr<lexer_action_executor> type = std::make_shared<lexer_action_executor>(std::vector<std::shared_ptr<lexer_action>> { std::make_shared<lexer_action::type_action>(3) });
+			assert(lexer_action_executor::fix_offset_before_match(type, 2) == type);
+
+			std::shared_ptr<lexer_action_executor> custom = lexer_action_executor::append(type, std::make_shared<lexer_action::custom_action>(1, 0));
+			std::shared_ptr<lexer_action_executor> fixed = lexer_action_executor::fix_offset_before_match(custom, 2);
+			assert(fixed != custom);
+			assert(fixed->actions()[1]->action_type() == lexer_action::lexer_action_type::indexed_custom);
+			assert(lexer_action_executor::fix_offset_before_match(fixed, 3) == fixed);
+
+			// the result is remembered for each offset
+			assert(lexer_action_executor::fix_offset_before_match(custom, 2) == fixed);
+			assert(lexer_action_executor::fix_offset_before_match(custom, 3) != fixed);
+
+			// wrappers created with a cache are interned across executors
+			lexer_action_cache cache;
+			std::shared_ptr<lexer_action_executor> x = lexer_action_executor::fix_offset_before_match(lexer_action_executor::append(nullptr, std::make_shared<lexer_action::custom_action>(1, 0)), 4, cache);
+			std::shared_ptr<lexer_action_executor> y = lexer_action_executor::fix_offset_before_match(lexer_action_executor::append(type, std::make_shared<lexer_action::custom_action>(1, 0)), 4, cache);
+			assert(x->actions()[0] == y->actions()[1]);
+
+			// a result created without a cache is not handed to callers with one, whose wrappers must be interned
+			std::shared_ptr<lexer_action_executor> interned = lexer_action_executor::fix_offset_before_match(custom, 2, cache);
+			assert(interned != fixed);
+			assert(interned->actions()[1] == cache.get_as_cached(fixed->actions()[1]));
+			assert(lexer_action_executor::fix_offset_before_match(custom, 2, cache) == interned);
+			assert(cache.id() != 0 && cache.id() != lexer_action_cache().id() && lexer_action_cache::uncached().id() == 0);
+
+			// only the most recent result for an offset is remembered, so the memo stays bounded
+			std::shared_ptr<lexer_action_executor> uncached = lexer_action_executor::fix_offset_before_match(custom, 2);
+			assert(uncached != interned && uncached->actions()[1] != interned->actions()[1]);
+			assert(lexer_action_executor::fix_offset_before_match(custom, 3) == lexer_action_executor::fix_offset_before_match(custom, 3));
+			std::shared_ptr<lexer_action_executor> colliding = lexer_action_executor::fix_offset_before_match(custom, 2 + lexer_action_executor::offset_fix_slots);
+			assert(lexer_action_executor::fix_offset_before_match(custom, 2 + lexer_action_executor::offset_fix_slots) == colliding);
+			assert(lexer_action_executor::fix_offset_before_match(custom, 2) != uncached);
+		}
+
+		void test_executor_table_dispatch()
+		{
+			std::shared_ptr<lexer_action> first = std::make_shared<lexer_action::custom_action>(0, 0);
+			std::shared_ptr<lexer_action> second = std::make_shared<lexer_action::custom_action>(2, 1);
+			std::vector<std::shared_ptr<lexer_action>> actions {
+				first,
+				std::make_shared<lexer_action::indexed_custom_action>(1, second),
+				std::make_shared<lexer_action::type_action>(3),
+			};
+
+			lexer_custom_action_table table(std::vector<lexer_custom_action_table::function> { &table_action_0, &table_action_1 });
+			assert(table.covers(actions));
+			assert(!table.covers(std::vector<std::shared_ptr<lexer_action>> { std::make_shared<lexer_action::custom_action>(2, 2) }));
+
+			lexer_action_executor executor(std::move(actions));
+			recording_target target(5);
+			executor.execute(target, 2, table);
+			assert(target.calls == (std::vector<std::string> { "table 0 @5", "table 1 @3", "type 3" }));
+			assert(target.index() == 5);
+		}
+
+		void test_action_cache()
+		{
+			lexer_action_cache cache;
+			std::shared_ptr<lexer_action> hidden = cache.get_as_cached(std::make_shared<lexer_action::channel_action>(1));
+			assert(hidden == cache.get_as_cached(std::make_shared<lexer_action::channel_action>(1)));
+			assert(hidden != cache.get_as_cached(std::make_shared<lexer_action::channel_action>(2)));
+
+			std::shared_ptr<lexer_action> custom = cache.get_as_cached(std::make_shared<lexer_action::custom_action>(1, 0));
+			std::shared_ptr<lexer_action> indexed = cache.get_as_cached(std::make_shared<lexer_action::indexed_custom_action>(2, std::make_shared<lexer_action::custom_action>(1, 0)));
+			assert(static_cast<lexer_action::indexed_custom_action const&>(*indexed).action() == custom);
+			assert(indexed == cache.get_as_cached(std::make_shared<lexer_action::indexed_custom_action>(2, custom)));
+			assert(cache.size() == 7);
+
+			lexer_action_cache uncached(lexer_action_cache::uncached());
+			assert(uncached.get_as_cached(hidden) == hidden);
+			assert(uncached.size() == 0);
+		}
+
+	}
+
+	void test_lexer_action()
+	{
+		test_action_equality();
+		test_executor_equality();
+		test_executor_append();
+		test_executor_execute();
+		test_executor_net_effect();
+		test_executor_fix_offset();
+		test_executor_table_dispatch();
+		test_action_cache();
+	}
+
+}
+}
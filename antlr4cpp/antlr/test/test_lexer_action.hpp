@@ -0,0 +1,10 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+namespace antlr {
+namespace test {
+
+	void test_lexer_action();
+
+}
+}
@@ -0,0 +1,255 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <functional>
+#include <vector>
+
+#include "test_semantic_context.hpp"
+
+#include <antlr/v4/runtime/atn/memoizing_predicate_evaluator.hpp>
+#include <antlr/v4/runtime/atn/predicate_evaluator.hpp>
+#include <antlr/v4/runtime/atn/predicated_alternatives.hpp>
+#include <antlr/v4/runtime/atn/semantic_context.hpp>
+#include <antlr/v4/runtime/atn/semantic_context_cache.hpp>
+#include <antlr/v4/runtime/atn/semantic_context_program.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr {
+namespace test {
+
+	using namespace antlr4::atn;
+
+	namespace {
+
+		// ------------ SUPPORT -------------------------
+
+		std::shared_ptr<semantic_context> pred(int32_t rule_index, int32_t predicate_index)
+		{
+			return std::make_shared<semantic_context::predicate>(rule_index, predicate_index, false);
+		}
+
+		std::shared_ptr<semantic_context> prec(int32_t precedence)
+		{
+			return std::make_shared<semantic_context::precedence_predicate>(precedence);
+		}
+
+		bool equal(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y)
+		{
+			std::hash<semantic_context> hasher;
+			return *x == *y && hasher(*x) == hasher(*y);
+		}
+
+		// Predicate (0, i) holds if bit i of the mask is set, and a precedence predicate holds if its precedence is at
+		// least the current precedence. Every invocation is recorded.
+		class recording_evaluator : public predicate_evaluator
+		{
+		public:
+			const uint32_t mask;
+			const int32_t current_precedence;
+			std::vector<int32_t> calls;
+
+		public:
+			recording_evaluator(uint32_t mask, int32_t current_precedence)
+				: mask(mask)
+				, current_precedence(current_precedence)
+			{
+			}
+
+			virtual bool sempred(std::shared_ptr<antlr4::rule_context> const& /*context*/, int32_t /*rule_index*/, int32_t predicate_index, bool /*context_dependent*/) override
+			{
+				calls.push_back(predicate_index);
+				return (mask & (1u << predicate_index)) != 0;
+			}
+
+			virtual bool precpred(std::shared_ptr<antlr4::rule_context> const& /*context*/, int32_t precedence) override
+			{
+				calls.push_back(-precedence);
+				return precedence >= current_precedence;
+			}
+		};
+
+		void check_program(std::shared_ptr<semantic_context> const& context, size_t predicate_count)
+		{
+			semantic_context_program program = semantic_context_program::compile(context);
+			for (uint32_t mask = 0; mask < (1u << predicate_count); mask++)
+			{
+				for (int32_t precedence = 0; precedence < 4; precedence++)
+				{
+					recording_evaluator expected(mask, precedence);
+					recording_evaluator actual(mask, precedence);
+					assert(context->eval(expected, nullptr) == program.eval(actual, nullptr));
+					assert(expected.calls == actual.calls);
+				}
+			}
+		}
+
+		// ------------ TESTS -------------------------
+
+		void test_and_operand_order()
+		{
+			std::shared_ptr<semantic_context> x = semantic_context::combine_and(semantic_context::combine_and(pred(0, 1), pred(0, 2)), pred(1, 0));
+			std::shared_ptr<semantic_context> y = semantic_context::combine_and(pred(1, 0), semantic_context::combine_and(pred(0, 2), pred(0, 1)));
+			assert(x != y);
+			assert(equal(x, y));
+
+			semantic_context::and_operator const& and_x = static_cast<semantic_context::and_operator const&>(*x);
+			semantic_context::and_operator const& and_y = static_cast<semantic_context::and_operator const&>(*y);
+			assert(and_x.operands().size() == 3);
+			for (size_t i = 0; i < and_x.operands().size(); i++)
+			{
+				assert(*and_x.operands()[i] == *and_y.operands()[i]);
+			}
+		}
+
+		void test_nested_operators()
+		{
+			std::shared_ptr<semantic_context> x = semantic_context::combine_or(semantic_context::combine_and(pred(0, 1), pred(0, 2)), pred(2, 0));
+			std::shared_ptr<semantic_context> y = semantic_context::combine_or(pred(2, 0), semantic_context::combine_and(pred(0, 2), pred(0, 1)));
+			std::shared_ptr<semantic_context> z = semantic_context::combine_or(pred(2, 0), semantic_context::combine_and(pred(0, 2), pred(0, 3)));
+			assert(equal(x, y));
+			assert(!(*x == *z));
+			assert(!(*semantic_context::combine_and(pred(0, 1), pred(0, 2)) == *semantic_context::combine_or(pred(0, 1), pred(0, 2))));
+		}
+
+		void test_duplicate_operands()
+		{
+			std::shared_ptr<semantic_context> x = semantic_context::combine_and(pred(0, 1), pred(0, 1));
+			assert(x->type() == semantic_context::context_type::predicate);
+			assert(equal(x, pred(0, 1)));
+		}
+
+		void test_precedence_reduction()
+		{
+			std::shared_ptr<semantic_context> x = semantic_context::combine_and(semantic_context::combine_and(prec(3), pred(0, 1)), prec(1));
+			std::shared_ptr<semantic_context> y = semantic_context::combine_and(pred(0, 1), prec(1));
+			assert(equal(x, y));
+
+			std::shared_ptr<semantic_context> z = semantic_context::combine_or(semantic_context::combine_or(prec(3), pred(0, 1)), prec(1));
+			std::shared_ptr<semantic_context> w = semantic_context::combine_or(pred(0, 1), prec(3));
+			assert(equal(z, w));
+		}
+
+		void test_cache()
+		{
+			semantic_context_cache cache;
+			std::shared_ptr<semantic_context> x = cache.get_as_cached(semantic_context::combine_and(pred(0, 1), pred(0, 2)));
+			std::shared_ptr<semantic_context> y = cache.get_as_cached(semantic_context::combine_and(pred(0, 2), pred(0, 1)));
+			assert(x == y);
+			assert(cache.get_as_cached(pred(-1, -1)) == semantic_context::none);
+			assert(cache.get_as_cached(prec(2)) == cache.get_as_cached(prec(2)));
+			assert(cache.size() == 3);
+
+			semantic_context_cache uncached(semantic_context_cache::uncached());
+			std::shared_ptr<semantic_context> z = pred(0, 1);
+			assert(uncached.get_as_cached(z) == z);
+			assert(uncached.size() == 0);
+		}
+
+		void test_compiled_program()
+		{
+			check_program(semantic_context::none, 0);
+			check_program(pred(0, 0), 1);
+			check_program(semantic_context::combine_and(pred(0, 0), prec(2)), 1);
+			check_program(semantic_context::combine_or(pred(0, 0), semantic_context::combine_and(pred(0, 1), pred(0, 2))), 3);
+
+			std::shared_ptr<semantic_context> nested = semantic_context::combine_and(
+				semantic_context::combine_or(pred(0, 0), semantic_context::combine_and(pred(0, 1), pred(0, 2))),
+				semantic_context::combine_or(pred(0, 3), semantic_context::combine_and(pred(0, 4), prec(1))));
+			check_program(nested, 5);
+
+			semantic_context_program program = semantic_context_program::compile(semantic_context::combine_or(pred(0, 0), semantic_context::combine_and(pred(0, 0), pred(0, 1))));
+			assert(program.predicates().size() == 2);
+		}
+
+		void test_memoized_predicates()
+		{
+			recording_evaluator evaluator(0x5, 1);
+			memoizing_predicate_evaluator memo(evaluator);
+			semantic_context_program program = semantic_context_program::compile(semantic_context::combine_and(pred(0, 0), prec(2)));
+
+			memo.position(3, 1);
+			assert(program.eval(memo, nullptr));
+			assert(program.eval(memo, nullptr));
+			assert(semantic_context::combine_and(pred(0, 2), pred(0, 0))->eval(memo, nullptr));
+			assert((evaluator.calls == std::vector<int32_t> { 0, -2, -2, 2 }));
+			assert(memo.size() == 2);
+
+			// a new position or precedence evaluates the predicate again
+			memo.position(4, 1);
+			assert(pred(0, 0)->eval(memo, nullptr));
+			memo.position(4, 2);
+			assert(pred(0, 0)->eval(memo, nullptr));
+			assert(memo.size() == 4);
+
+			// context-dependent predicates are never memoized, even when evaluated without a context
+			std::shared_ptr<semantic_context> dependent = std::make_shared<semantic_context::predicate>(0, 2, true);
+			evaluator.calls.clear();
+			assert(dependent->eval(memo, nullptr));
+			assert(dependent->eval(memo, nullptr));
+			assert((evaluator.calls == std::vector<int32_t> { 2, 2 }));
+			assert(memo.size() == 4);
+
+			memo.clear();
+			assert(memo.size() == 0);
+		}
+
+		void test_interned_combinations()
+		{
+			assert(semantic_context::precedence_predicate::instance(3) == semantic_context::precedence_predicate::instance(3));
+			assert(semantic_context::precedence_predicate::instance(3) != semantic_context::precedence_predicate::instance(4));
+
+			semantic_context_cache cache;
+			std::shared_ptr<semantic_context> x = cache.combine_and(pred(0, 1), cache.precedence_predicate(2));
+			std::shared_ptr<semantic_context> y = cache.combine_and(cache.precedence_predicate(2), pred(0, 1));
+			assert(x == y);
+			assert(x->type() == semantic_context::context_type::and_operator);
+
+			std::shared_ptr<semantic_context> z = cache.combine_or(x, pred(0, 3));
+			assert(z == cache.combine_or(pred(0, 3), semantic_context::combine_and(pred(0, 1), prec(2))));
+			assert(cache.combine_or(x, semantic_context::none) == semantic_context::none);
+		}
+
+		void test_predicated_alternatives()
+		{
+			std::shared_ptr<semantic_context> shared = semantic_context::combine_and(pred(0, 0), prec(2));
+			predicated_alternatives alternatives(std::vector<std::pair<std::shared_ptr<semantic_context>, size_t>> {
+				std::make_pair(semantic_context::combine_and(shared, pred(0, 1)), 1),
+				std::make_pair(semantic_context::combine_or(shared, pred(0, 2)), 2),
+				std::make_pair(semantic_context::combine_and(pred(0, 0), pred(0, 2)), 3),
+				std::make_pair(semantic_context::none, 4),
+			});
+			assert(alternatives.size() == 4);
+			assert(alternatives.leaf_count() == 4);
+
+			// predicates 0 and 2 hold, and precedence 2 holds at precedence 1
+			recording_evaluator complete(0x5, 1);
+			assert((alternatives.eval(complete, nullptr, true) == std::vector<bool> { false, false, true, true, true }));
+			assert((complete.calls == std::vector<int32_t> { 0, 1, 2 }));
+
+			recording_evaluator first(0x5, 1);
+			assert((alternatives.eval(first, nullptr, false) == std::vector<bool> { false, false, true, false, false }));
+			assert((first.calls == std::vector<int32_t> { 0, 1, 2 }));
+		}
+
+	}
+
+	void test_semantic_context()
+	{
+		test_and_operand_order();
+		test_nested_operators();
+		test_duplicate_operands();
+		test_precedence_reduction();
+		test_cache();
+		test_compiled_program();
+		test_memoized_predicates();
+		test_interned_combinations();
+		test_predicated_alternatives();
+	}
+
+}
+}
@@ -11,11 +11,21 @@ namespace atn {
 		bool _generate_rule_bypass_transitions;
 		bool _optimize;
 
+		// The individual passes run when optimize is set.
+		bool _inline_trivial_rules;
+		bool _collapse_epsilon_chains;
+		bool _merge_sets;
+		bool _mark_tail_calls;
+
 	public:
 		atn_deserialization_options()
 			: _verify_atn(true)
 			, _generate_rule_bypass_transitions(false)
 			, _optimize(true)
+			, _inline_trivial_rules(true)
+			, _collapse_epsilon_chains(true)
+			, _merge_sets(true)
+			, _mark_tail_calls(true)
 		{
 		}
 
@@ -55,6 +65,46 @@ namespace atn {
 		{
 			_optimize = value;
 		}
+
+		bool inline_trivial_rules() const
+		{
+			return _inline_trivial_rules;
+		}
+
+		void inline_trivial_rules(bool value)
+		{
+			_inline_trivial_rules = value;
+		}
+
+		bool collapse_epsilon_chains() const
+		{
+			return _collapse_epsilon_chains;
+		}
+
+		void collapse_epsilon_chains(bool value)
+		{
+			_collapse_epsilon_chains = value;
+		}
+
+		bool merge_sets() const
+		{
+			return _merge_sets;
+		}
+
+		void merge_sets(bool value)
+		{
+			_merge_sets = value;
+		}
+
+		bool mark_tail_calls() const
+		{
+			return _mark_tail_calls;
+		}
+
+		void mark_tail_calls(bool value)
+		{
+			_mark_tail_calls = value;
+		}
 	};
 
 }
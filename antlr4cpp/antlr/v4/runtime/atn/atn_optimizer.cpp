@@ -0,0 +1,523 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <antlr/v4/runtime/atn/atn_optimizer.hpp>
+
+#include <antlr/v4/runtime/atn/atn_deserialization_options.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+#include <antlr/v4/runtime/misc/interval_set.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		typedef std::vector<std::shared_ptr<transition>> transition_list;
+
+		bool is_decision_state(atn_state const& state)
+		{
+			switch (state.state_type())
+			{
+			case atn_state::atn_state_type::block_start:
+			case atn_state::atn_state_type::plus_block_start:
+			case atn_state::atn_state_type::star_block_start:
+			case atn_state::atn_state_type::token_start:
+			case atn_state::atn_state_type::star_loop_entry:
+			case atn_state::atn_state_type::plus_loop_back:
+				return true;
+
+			default:
+				return false;
+			}
+		}
+
+		bool is_match_transition(transition const& transition)
+		{
+			switch (transition.type())
+			{
+			case transition::transition_type::atom:
+			case transition::transition_type::range:
+			case transition::transition_type::set:
+				return true;
+
+			default:
+				// not_set and wildcard transitions are not inlined or merged yet
+				return false;
+			}
+		}
+
+		void replace_optimized_transitions(atn_state& state, transition_list const& transitions)
+		{
+			if (state.optimized())
+			{
+				while (!state.optimized_transitions().empty())
+				{
+					state.remove_optimized_transition(state.optimized_transitions().size() - 1);
+				}
+			}
+
+			for (size_t i = 0; i < transitions.size(); i++)
+			{
+				state.add_optimized_transition(i, transitions[i]);
+			}
+		}
+
+		std::shared_ptr<basic_state> add_basic_state(grammar_atn& atn, size_t rule_index)
+		{
+			std::shared_ptr<basic_state> state = std::make_shared<basic_state>(atn.states().size(), rule_index);
+			atn.add_state(state);
+			return state;
+		}
+
+		std::shared_ptr<transition> copy_match_transition(transition const& match, std::shared_ptr<atn_state> const& target)
+		{
+			switch (match.type())
+			{
+			case transition::transition_type::atom:
+				return std::make_shared<atom_transition>(target, static_cast<atom_transition const&>(match).label());
+
+			case transition::transition_type::range:
+				return std::make_shared<range_transition>(target, static_cast<range_transition const&>(match).label());
+
+			case transition::transition_type::set:
+				return std::make_shared<set_transition>(target, static_cast<set_transition const&>(match).shared_label());
+
+			default:
+				assert(!"Invalid match transition type.");
+				return nullptr;
+			}
+		}
+
+		void add_label(misc::interval_set<int32_t>& set, transition const& match)
+		{
+			switch (match.type())
+			{
+			case transition::transition_type::atom:
+				set.insert(static_cast<atom_transition const&>(match).label());
+				break;
+
+			case transition::transition_type::range:
+				set.insert(static_cast<range_transition const&>(match).label());
+				break;
+
+			case transition::transition_type::set:
+				set.insert(static_cast<set_transition const&>(match).label());
+				break;
+
+			default:
+				assert(!"Invalid match transition type.");
+				break;
+			}
+		}
+
+		// Counts the states reachable from the rule start states, and their optimized transitions.
+		std::pair<size_t, size_t> count_reachable(grammar_atn const& atn)
+		{
+			std::vector<bool> reachable(atn.states().size());
+			std::vector<atn_state const*> worklist;
+			for each (std::shared_ptr<rule_start_state> const& start_state in atn.rule_start_states())
+			{
+				if (start_state)
+				{
+					worklist.push_back(start_state.get());
+				}
+			}
+
+			std::pair<size_t, size_t> result(0, 0);
+			while (!worklist.empty())
+			{
+				atn_state const* state = worklist.back();
+				worklist.pop_back();
+				if (reachable[state->state_number()])
+				{
+					continue;
+				}
+
+				reachable[state->state_number()] = true;
+				result.first++;
+				result.second += state->optimized_transitions().size();
+				for each (std::shared_ptr<transition> const& transition in state->optimized_transitions())
+				{
+					worklist.push_back(transition->target().get());
+					if (transition->type() == transition::transition_type::rule)
+					{
+						worklist.push_back(static_cast<rule_transition const&>(*transition).follow_state().get());
+					}
+				}
+			}
+
+			return result;
+		}
+
+		size_t run_pass(grammar_atn& atn, size_t (*pass)(grammar_atn&), atn_optimizer::pass_statistics& statistics)
+		{
+			std::pair<size_t, size_t> before = count_reachable(atn);
+			size_t optimizations = pass(atn);
+			std::pair<size_t, size_t> after = count_reachable(atn);
+
+			statistics.optimizations += optimizations;
+			statistics.removed_states += static_cast<ptrdiff_t>(before.first) - static_cast<ptrdiff_t>(after.first);
+			statistics.removed_transitions += static_cast<ptrdiff_t>(before.second) - static_cast<ptrdiff_t>(after.second);
+			return optimizations;
+		}
+
+		// A call is a tail call if only epsilon transitions lead from its follow state to the end of the calling rule.
+		bool test_tail_call(grammar_atn const& atn, rule_transition const& transition, bool optimized_path)
+		{
+			std::vector<bool> reachable(atn.states().size());
+			std::vector<atn_state const*> worklist(1, transition.follow_state().get());
+			while (!worklist.empty())
+			{
+				atn_state const* state = worklist.back();
+				worklist.pop_back();
+				if (reachable[state->state_number()] || state->state_type() == atn_state::atn_state_type::rule_stop)
+				{
+					continue;
+				}
+
+				reachable[state->state_number()] = true;
+				if (!state->only_has_epsilon_transitions())
+				{
+					return false;
+				}
+
+				for each (std::shared_ptr<atn::transition> const& next in (optimized_path ? state->optimized_transitions() : state->transitions()))
+				{
+					if (next->type() != transition::transition_type::epsilon)
+					{
+						return false;
+					}
+
+					worklist.push_back(next->target().get());
+				}
+			}
+
+			return true;
+		}
+
+		void mark_tail_call(grammar_atn const& atn, transition& transition, std::unordered_set<atn::transition const*>& marked)
+		{
+			if (transition.type() != transition::transition_type::rule)
+			{
+				return;
+			}
+
+			rule_transition& call = static_cast<rule_transition&>(transition);
+			call.tail_call(call.tail_call() || test_tail_call(atn, call, false));
+			call.optimized_tail_call(call.optimized_tail_call() || test_tail_call(atn, call, true));
+			if (call.tail_call() || call.optimized_tail_call())
+			{
+				marked.insert(&call);
+			}
+		}
+
+	}
+
+	atn_optimizer::statistics atn_optimizer::optimize(grammar_atn& atn, atn_deserialization_options const& options)
+	{
+		statistics result = {};
+		if (!options.optimize())
+		{
+			return result;
+		}
+
+		while (true)
+		{
+			size_t optimizations = 0;
+			if (options.inline_trivial_rules())
+			{
+				optimizations += run_pass(atn, &atn_optimizer::inline_trivial_rules, result.inline_trivial_rules);
+			}
+
+			if (options.collapse_epsilon_chains())
+			{
+				optimizations += run_pass(atn, &atn_optimizer::collapse_epsilon_chains, result.collapse_epsilon_chains);
+			}
+
+			if (options.merge_sets())
+			{
+				optimizations += run_pass(atn, &atn_optimizer::merge_sets, result.merge_sets);
+			}
+
+			if (optimizations == 0)
+			{
+				break;
+			}
+		}
+
+		if (options.mark_tail_calls())
+		{
+			run_pass(atn, &atn_optimizer::mark_tail_calls, result.mark_tail_calls);
+		}
+
+		return result;
+	}
+
+	size_t atn_optimizer::inline_trivial_rules(grammar_atn& atn)
+	{
+		// find the single match transition of each rule which has one
+		std::vector<std::shared_ptr<transition>> rule_to_inline_transition(atn.rule_start_states().size());
+		for (size_t i = 0; i < atn.rule_start_states().size(); i++)
+		{
+			atn_state const* middle_state = atn.rule_start_states()[i].get();
+			if (!middle_state)
+			{
+				continue;
+			}
+
+			while (middle_state->only_has_epsilon_transitions()
+				&& middle_state->optimized_transitions().size() == 1
+				&& middle_state->optimized_transition(0)->type() == transition::transition_type::epsilon)
+			{
+				middle_state = middle_state->optimized_transition(0)->target().get();
+			}
+
+			if (middle_state->optimized_transitions().size() != 1)
+			{
+				continue;
+			}
+
+			std::shared_ptr<transition> const& match_transition = middle_state->optimized_transition(0);
+			atn_state const& match_target = *match_transition->target();
+			if (!is_match_transition(*match_transition)
+				|| !match_target.only_has_epsilon_transitions()
+				|| match_target.optimized_transitions().size() != 1
+				|| match_target.optimized_transition(0)->target()->state_type() != atn_state::atn_state_type::rule_stop)
+			{
+				continue;
+			}
+
+			rule_to_inline_transition[i] = match_transition;
+		}
+
+		size_t inlined_calls = 0;
+		for (size_t state_number = 0, state_count = atn.states().size(); state_number < state_count; state_number++)
+		{
+			std::shared_ptr<atn_state> state = atn.states()[state_number];
+			if (!state)
+			{
+				continue;
+			}
+
+			bool changed = false;
+			transition_list optimized_transitions;
+			for each (std::shared_ptr<transition> const& transition in state->optimized_transitions())
+			{
+				if (transition->type() != transition::transition_type::rule)
+				{
+					optimized_transitions.push_back(transition);
+					continue;
+				}
+
+				rule_transition const& call = static_cast<rule_transition const&>(*transition);
+				size_t rule_index = call.target()->rule_index();
+				if (rule_index >= rule_to_inline_transition.size() || !rule_to_inline_transition[rule_index])
+				{
+					optimized_transitions.push_back(transition);
+					continue;
+				}
+
+				changed = true;
+				inlined_calls++;
+				std::shared_ptr<basic_state> intermediate_state = add_basic_state(atn, call.follow_state()->rule_index());
+				intermediate_state->add_transition(copy_match_transition(*rule_to_inline_transition[rule_index], call.follow_state()));
+				optimized_transitions.push_back(std::make_shared<epsilon_transition>(intermediate_state, -1));
+			}
+
+			if (changed)
+			{
+				replace_optimized_transitions(*state, optimized_transitions);
+			}
+		}
+
+		return inlined_calls;
+	}
+
+	size_t atn_optimizer::collapse_epsilon_chains(grammar_atn& atn)
+	{
+		size_t inlined_transitions = 0;
+		for each (std::shared_ptr<atn_state> const& state in atn.states())
+		{
+			if (!state || !state->only_has_epsilon_transitions() || state->state_type() == atn_state::atn_state_type::rule_stop)
+			{
+				continue;
+			}
+
+			bool changed = false;
+			transition_list optimized_transitions;
+			for each (std::shared_ptr<transition> const& transition in state->optimized_transitions())
+			{
+				atn_state const& intermediate = *transition->target();
+				bool collapse = is_plain_epsilon(*transition)
+					&& &intermediate != state.get()
+					&& intermediate.state_type() == atn_state::atn_state_type::basic
+					&& intermediate.only_has_epsilon_transitions();
+				if (collapse)
+				{
+					for each (std::shared_ptr<atn::transition> const& next in intermediate.optimized_transitions())
+					{
+						if (!is_plain_epsilon(*next))
+						{
+							collapse = false;
+							break;
+						}
+					}
+				}
+
+				if (!collapse)
+				{
+					optimized_transitions.push_back(transition);
+					continue;
+				}
+
+				changed = true;
+				inlined_transitions++;
+				for each (std::shared_ptr<atn::transition> const& next in intermediate.optimized_transitions())
+				{
+					optimized_transitions.push_back(std::make_shared<epsilon_transition>(next->target(), -1));
+				}
+			}
+
+			if (changed)
+			{
+				replace_optimized_transitions(*state, optimized_transitions);
+			}
+		}
+
+		return inlined_transitions;
+	}
+
+	size_t atn_optimizer::merge_sets(grammar_atn& atn)
+	{
+		if (atn.grammar_type() == atn_type::lexer)
+		{
+			return 0;
+		}
+
+		size_t removed_alternatives = 0;
+		for (size_t state_number = 0, state_count = atn.states().size(); state_number < state_count; state_number++)
+		{
+			std::shared_ptr<atn_state> decision = atn.states()[state_number];
+			if (!decision || !is_decision_state(*decision))
+			{
+				continue;
+			}
+
+			// the alternatives which match a single atom, range or set and then reach the end of the block
+			std::shared_ptr<atn_state> block_end_state;
+			std::vector<bool> set_alternatives(decision->optimized_transitions().size());
+			size_t set_alternative_count = 0;
+			for (size_t i = 0; i < decision->optimized_transitions().size(); i++)
+			{
+				std::shared_ptr<transition> const& epsilon = decision->optimized_transition(i);
+				if (epsilon->type() != transition::transition_type::epsilon || epsilon->target()->optimized_transitions().size() != 1)
+				{
+					continue;
+				}
+
+				std::shared_ptr<transition> const& match = epsilon->target()->optimized_transition(0);
+				if (!is_match_transition(*match) || match->target()->state_type() != atn_state::atn_state_type::block_end)
+				{
+					continue;
+				}
+
+				if (!block_end_state)
+				{
+					block_end_state = match->target();
+				}
+				else if (block_end_state != match->target())
+				{
+					continue;
+				}
+
+				set_alternatives[i] = true;
+				set_alternative_count++;
+			}
+
+			if (set_alternative_count <= 1)
+			{
+				continue;
+			}
+
+			transition_list optimized_transitions;
+			misc::interval_set<int32_t> match_set;
+			for (size_t i = 0; i < decision->optimized_transitions().size(); i++)
+			{
+				if (set_alternatives[i])
+				{
+					add_label(match_set, *decision->optimized_transition(i)->target()->optimized_transition(0));
+				}
+				else
+				{
+					optimized_transitions.push_back(decision->optimized_transition(i));
+				}
+			}
+
+			std::shared_ptr<transition> new_transition;
+			if (match_set.pairs().size() == 1 && match_set.size() == 1)
+			{
+				new_transition = std::make_shared<atom_transition>(block_end_state, match_set.min());
+			}
+			else if (match_set.pairs().size() == 1)
+			{
+				new_transition = std::make_shared<range_transition>(block_end_state, match_set.pairs()[0]);
+			}
+			else
+			{
+				new_transition = std::make_shared<set_transition>(block_end_state, std::make_shared<misc::interval_set<int32_t>>(std::move(match_set)));
+			}
+
+			std::shared_ptr<basic_state> set_optimized_state = add_basic_state(atn, decision->rule_index());
+			set_optimized_state->add_transition(new_transition);
+			optimized_transitions.push_back(std::make_shared<epsilon_transition>(set_optimized_state, -1));
+
+			removed_alternatives += decision->optimized_transitions().size() - optimized_transitions.size();
+			replace_optimized_transitions(*decision, optimized_transitions);
+		}
+
+		return removed_alternatives;
+	}
+
+	size_t atn_optimizer::mark_tail_calls(grammar_atn& atn)
+	{
+		std::unordered_set<transition const*> marked;
+		for each (std::shared_ptr<atn_state> const& state in atn.states())
+		{
+			if (!state)
+			{
+				continue;
+			}
+
+			for each (std::shared_ptr<transition> const& transition in state->transitions())
+			{
+				mark_tail_call(atn, *transition, marked);
+			}
+
+			if (!state->optimized())
+			{
+				continue;
+			}
+
+			for each (std::shared_ptr<transition> const& transition in state->optimized_transitions())
+			{
+				mark_tail_call(atn, *transition, marked);
+			}
+		}
+
+		return marked.size();
+	}
+
+}
+}
@@ -0,0 +1,58 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstddef>
+
+namespace antlr4 {
+namespace atn {
+
+	class atn_deserialization_options;
+	class grammar_atn;
+
+	// Rewrites the optimized transitions of a deserialized ATN so prediction has fewer states to visit. The original
+	// transitions of each state are left as they are.
+	class atn_optimizer
+	{
+	public:
+		// What one pass did, summed over every time it ran. States and transitions are counted over the states reachable
+		// from the rule start states, so a pass which adds intermediate states can report negative removals.
+		struct pass_statistics
+		{
+			size_t optimizations;
+			ptrdiff_t removed_states;
+			ptrdiff_t removed_transitions;
+		};
+
+		struct statistics
+		{
+			pass_statistics inline_trivial_rules;
+			pass_statistics collapse_epsilon_chains;
+			pass_statistics merge_sets;
+			pass_statistics mark_tail_calls;
+		};
+
+	public:
+		// Runs the passes enabled in options until none of them finds anything left to optimize, then marks tail calls.
+		// Nothing is done unless options.optimize() is set.
+		static statistics optimize(grammar_atn& atn, atn_deserialization_options const& options);
+
+		// Replaces calls to rules which match exactly one atom, range or set with that match. Returns the number of
+		// calls inlined.
+		static size_t inline_trivial_rules(grammar_atn& atn);
+
+		// Replaces epsilon transitions to basic states which only have plain epsilon transitions with epsilon
+		// transitions to the targets of those. Returns the number of transitions replaced.
+		static size_t collapse_epsilon_chains(grammar_atn& atn);
+
+		// Replaces the alternatives of a parser decision which each match a single atom, range or set with one
+		// alternative matching the union. Lexer decisions are left alone since the order of their alternatives matters.
+		// Returns the number of alternatives removed.
+		static size_t merge_sets(grammar_atn& atn);
+
+		// Sets rule_transition::tail_call and rule_transition::optimized_tail_call for calls which are followed only by
+		// epsilon transitions to the end of the calling rule. Returns the number of calls marked.
+		static size_t mark_tail_calls(grammar_atn& atn);
+	};
+
+}
+}
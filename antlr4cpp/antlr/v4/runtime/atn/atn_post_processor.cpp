@@ -0,0 +1,526 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <antlr/v4/runtime/atn/atn_post_processor.hpp>
+
+#include <antlr/v4/runtime/atn/atn_deserialization_options.hpp>
+#include <antlr/v4/runtime/atn/atn_optimizer.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		typedef std::vector<std::vector<std::shared_ptr<atn_state>>> rule_partition;
+
+		// Groups the states of atn by rule, in state order. States which belong to no rule are placed after the rules.
+		rule_partition partition(grammar_atn const& atn)
+		{
+			rule_partition result(atn.rule_start_states().size() + 1);
+			for each (std::shared_ptr<atn_state> const& state in atn.states())
+			{
+				if (state)
+				{
+					result[std::min(state->rule_index(), atn.rule_start_states().size())].push_back(state);
+				}
+			}
+
+			return result;
+		}
+
+		// Calls work for each index below count on up to thread_count threads. Each index is handled by a single thread,
+		// and an exception thrown by work is rethrown on the calling thread once every thread has finished.
+		void parallel_for(size_t count, size_t thread_count, std::function<void(size_t)> const& work)
+		{
+			if (thread_count == 0)
+			{
+				thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+			}
+
+			thread_count = std::min(thread_count, count);
+			if (thread_count <= 1)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					work(i);
+				}
+
+				return;
+			}
+
+			std::atomic<size_t> next(0);
+			std::vector<std::exception_ptr> errors(thread_count);
+			auto worker = [&](size_t thread_index)
+			{
+				try
+				{
+					for (size_t i = next++; i < count; i = next++)
+					{
+						work(i);
+					}
+				}
+				catch (...)
+				{
+					errors[thread_index] = std::current_exception();
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for (size_t i = 1; i < thread_count; i++)
+			{
+				threads.push_back(std::thread(worker, i));
+			}
+
+			worker(0);
+			for (size_t i = 0; i < threads.size(); i++)
+			{
+				threads[i].join();
+			}
+
+			for each (std::exception_ptr const& error in errors)
+			{
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+		}
+
+		// The state ending the prefix of a precedence rule: the star loop entry whose exit leads straight to the end of
+		// the rule.
+		bool precedence_decision(atn_state const& state)
+		{
+			if (state.state_type() != atn_state::atn_state_type::star_loop_entry || state.transitions().empty())
+			{
+				return false;
+			}
+
+			atn_state const& maybe_loop_end = *state.transitions().back()->target();
+			return maybe_loop_end.state_type() == atn_state::atn_state_type::loop_end
+				&& maybe_loop_end.only_has_epsilon_transitions()
+				&& maybe_loop_end.transition(0)->target()->state_type() == atn_state::atn_state_type::rule_stop;
+		}
+
+		// Links the states of the blocks and loops of one rule and its stop state, marks its precedence decision, and
+		// collects the return transitions its calls add to the stop states of the rules they call.
+		void link_rule(grammar_atn const& atn, std::vector<std::shared_ptr<atn_state>> const& states, std::vector<std::pair<size_t, std::shared_ptr<transition>>>& returns)
+		{
+			for each (std::shared_ptr<atn_state> const& state in states)
+			{
+				switch (state->state_type())
+				{
+				case atn_state::atn_state_type::block_start:
+				case atn_state::atn_state_type::plus_block_start:
+				case atn_state::atn_state_type::star_block_start:
+					if (static_cast<block_start_state&>(*state).end_state())
+					{
+						static_cast<block_start_state&>(*state).end_state()->start_state(std::static_pointer_cast<block_start_state>(state));
+					}
+
+					break;
+
+				case atn_state::atn_state_type::plus_loop_back:
+					for each (std::shared_ptr<transition> const& transition in state->transitions())
+					{
+						if (transition->target()->state_type() == atn_state::atn_state_type::plus_block_start)
+						{
+							static_cast<plus_block_start_state&>(*transition->target()).loopback_state(std::static_pointer_cast<plus_loopback_state>(state));
+						}
+					}
+
+					break;
+
+				case atn_state::atn_state_type::star_loop_back:
+					for each (std::shared_ptr<transition> const& transition in state->transitions())
+					{
+						if (transition->target()->state_type() == atn_state::atn_state_type::star_loop_entry)
+						{
+							static_cast<star_loop_entry_state&>(*transition->target()).loopback_state(std::static_pointer_cast<star_loopback_state>(state));
+						}
+					}
+
+					break;
+
+				case atn_state::atn_state_type::rule_stop:
+					if (state->rule_index() < atn.rule_start_states().size())
+					{
+						atn.rule_start_states()[state->rule_index()]->stop_state(std::static_pointer_cast<rule_stop_state>(state));
+					}
+
+					break;
+
+				case atn_state::atn_state_type::star_loop_entry:
+					if (state->rule_index() < atn.rule_start_states().size() && atn.rule_start_states()[state->rule_index()]->precedence_rule())
+					{
+						static_cast<star_loop_entry_state&>(*state).precedence_rule_decision(precedence_decision(*state));
+					}
+
+					break;
+
+				default:
+					break;
+				}
+
+				for each (std::shared_ptr<transition> const& transition in state->transitions())
+				{
+					if (transition->type() != transition::transition_type::rule)
+					{
+						continue;
+					}
+
+					rule_transition const& call = static_cast<rule_transition const&>(*transition);
+					size_t called_rule = call.target()->rule_index();
+					int32_t outermost_precedence_return = -1;
+					if (atn.rule_start_states()[called_rule]->precedence_rule() && call.precedence() == 0)
+					{
+						outermost_precedence_return = static_cast<int32_t>(called_rule);
+					}
+
+					returns.push_back(std::make_pair(called_rule, std::make_shared<epsilon_transition>(call.follow_state(), outermost_precedence_return)));
+				}
+			}
+		}
+
+		std::shared_ptr<transition> retarget(grammar_atn const& atn, transition const& transition, std::shared_ptr<atn_state> const& target)
+		{
+			switch (transition.type())
+			{
+			case transition::transition_type::epsilon:
+				return std::make_shared<epsilon_transition>(target, static_cast<epsilon_transition const&>(transition).outermost_precedence_return());
+
+			case transition::transition_type::range:
+				return std::make_shared<range_transition>(target, static_cast<range_transition const&>(transition).label());
+
+			case transition::transition_type::rule:
+			{
+				rule_transition const& call = static_cast<rule_transition const&>(transition);
+				std::shared_ptr<rule_transition> result = std::make_shared<rule_transition>(target, call.rule_index(), call.precedence(), call.follow_state());
+				result->tail_call(call.tail_call());
+				result->optimized_tail_call(call.optimized_tail_call());
+				return result;
+			}
+
+			case transition::transition_type::predicate:
+			{
+				predicate_transition const& predicate = static_cast<predicate_transition const&>(transition);
+				return std::make_shared<predicate_transition>(target, predicate.rule_index(), predicate.predicate_index(), predicate.context_dependent());
+			}
+
+			case transition::transition_type::atom:
+				return std::make_shared<atom_transition>(target, static_cast<atom_transition const&>(transition).label());
+
+			case transition::transition_type::action:
+			{
+				action_transition const& action = static_cast<action_transition const&>(transition);
+				return std::make_shared<action_transition>(target, action.rule_index(), action.action_index(), action.context_dependent());
+			}
+
+			case transition::transition_type::set:
+				return std::make_shared<set_transition>(target, static_cast<set_transition const&>(transition).shared_label());
+
+			case transition::transition_type::not_set:
+				return std::make_shared<not_set_transition>(target, static_cast<set_transition const&>(transition).shared_label(), 1, atn.max_token_type());
+
+			case transition::transition_type::wildcard:
+				return std::make_shared<wildcard_transition>(target);
+
+			case transition::transition_type::precedence:
+				return std::make_shared<precedence_transition>(target, static_cast<precedence_transition const&>(transition).precedence());
+
+			default:
+				assert(!"Invalid transition type.");
+				return nullptr;
+			}
+		}
+
+		// The states added for the bypass alternative of one rule, numbered in rule order before the rules are rewired.
+		struct bypass_states
+		{
+			std::shared_ptr<basic_block_start_state> start;
+			std::shared_ptr<block_end_state> stop;
+			std::shared_ptr<basic_state> match;
+		};
+
+		// Moves the transitions of the start state of a rule into a new block with an extra alternative matching the
+		// token type of the rule, so the parser can match an entire rule invocation as a single token.
+		void generate_rule_bypass(grammar_atn const& atn, size_t rule_index, std::vector<std::shared_ptr<atn_state>> const& states, bypass_states const& bypass)
+		{
+			std::shared_ptr<rule_start_state> const& rule_start = atn.rule_start_states()[rule_index];
+			std::shared_ptr<atn_state> end_state;
+			transition const* exclude_transition = nullptr;
+			if (rule_start->precedence_rule())
+			{
+				// wrap from the beginning of the rule to the star loop entry ending its prefix
+				for each (std::shared_ptr<atn_state> const& state in states)
+				{
+					if (precedence_decision(*state))
+					{
+						end_state = state;
+						break;
+					}
+				}
+
+				if (!end_state)
+				{
+					throw std::runtime_error("Couldn't identify final state of the precedence rule prefix section.");
+				}
+
+				exclude_transition = static_cast<star_loop_entry_state&>(*end_state).loopback_state()->transition(0).get();
+			}
+			else
+			{
+				end_state = rule_start->stop_state();
+			}
+
+			// all transitions of the rule which lead to the end state now lead to the end of the bypass block
+			for each (std::shared_ptr<atn_state> const& state in states)
+			{
+				for (size_t i = 0; i < state->transitions().size(); i++)
+				{
+					std::shared_ptr<transition> const& transition = state->transition(i);
+					if (transition.get() != exclude_transition && transition->target() == end_state)
+					{
+						state->set_transition(i, retarget(atn, *transition, bypass.stop));
+					}
+				}
+			}
+
+			// all transitions leaving the rule start state now leave the bypass block
+			while (!rule_start->transitions().empty())
+			{
+				bypass.start->add_transition(rule_start->remove_transition(rule_start->transitions().size() - 1));
+			}
+
+			rule_start->add_transition(std::make_shared<epsilon_transition>(bypass.start, -1));
+			bypass.stop->add_transition(std::make_shared<epsilon_transition>(end_state, -1));
+			bypass.match->add_transition(std::make_shared<atom_transition>(bypass.stop, atn.max_token_type() + 1 + static_cast<int32_t>(rule_index)));
+			bypass.start->add_transition(std::make_shared<epsilon_transition>(bypass.match, -1));
+		}
+
+		void generate_rule_bypass_transitions(grammar_atn& atn, size_t thread_count)
+		{
+			rule_partition rules = partition(atn);
+			size_t rule_count = atn.rule_start_states().size();
+
+			std::vector<bypass_states> bypasses;
+			for (size_t i = 0; i < rule_count; i++)
+			{
+				bypass_states bypass;
+				bypass.start = std::make_shared<basic_block_start_state>(atn.states().size(), i);
+				atn.add_state(bypass.start);
+				bypass.stop = std::make_shared<block_end_state>(atn.states().size(), i);
+				atn.add_state(bypass.stop);
+				bypass.start->end_state(bypass.stop);
+				bypass.stop->start_state(bypass.start);
+				atn.add_decision_state(bypass.start);
+				bypass.match = std::make_shared<basic_state>(atn.states().size(), i);
+				atn.add_state(bypass.match);
+				bypasses.push_back(bypass);
+			}
+
+			parallel_for(rule_count, thread_count,
+				[&](size_t rule_index)
+				{
+					generate_rule_bypass(atn, rule_index, rules[rule_index], bypasses[rule_index]);
+				});
+		}
+
+		std::string invalid_state(atn_state const& state)
+		{
+			return "Invalid state definition: state " + std::to_string(state.state_number()) + " in rule " + std::to_string(state.rule_index()) + ".";
+		}
+
+		// Returns the empty string if state is valid, or a description of the problem.
+		std::string verify_state(atn_state const& state)
+		{
+			if (!state.only_has_epsilon_transitions() && state.transitions().size() > 1)
+			{
+				return invalid_state(state);
+			}
+
+			switch (state.state_type())
+			{
+			case atn_state::atn_state_type::plus_block_start:
+				if (!static_cast<plus_block_start_state const&>(state).loopback_state())
+				{
+					return invalid_state(state);
+				}
+
+				break;
+
+			case atn_state::atn_state_type::star_loop_entry:
+			{
+				star_loop_entry_state const& entry = static_cast<star_loop_entry_state const&>(state);
+				if (!entry.loopback_state() || entry.transitions().size() != 2)
+				{
+					return invalid_state(state);
+				}
+
+				atn_state::atn_state_type first = entry.transition(0)->target()->state_type();
+				atn_state::atn_state_type second = entry.transition(1)->target()->state_type();
+				bool greedy_loop = first == atn_state::atn_state_type::star_block_start && second == atn_state::atn_state_type::loop_end && entry.greedy();
+				bool non_greedy_loop = first == atn_state::atn_state_type::loop_end && second == atn_state::atn_state_type::star_block_start && !entry.greedy();
+				if (!greedy_loop && !non_greedy_loop)
+				{
+					return invalid_state(state);
+				}
+
+				break;
+			}
+
+			case atn_state::atn_state_type::star_loop_back:
+				if (state.transitions().size() != 1 || state.transition(0)->target()->state_type() != atn_state::atn_state_type::star_loop_entry)
+				{
+					return invalid_state(state);
+				}
+
+				break;
+
+			case atn_state::atn_state_type::loop_end:
+				if (!static_cast<loop_end_state const&>(state).loopback_state())
+				{
+					return invalid_state(state);
+				}
+
+				break;
+
+			case atn_state::atn_state_type::rule_start:
+				if (!static_cast<rule_start_state const&>(state).stop_state())
+				{
+					return invalid_state(state);
+				}
+
+				break;
+
+			case atn_state::atn_state_type::block_end:
+				if (!static_cast<block_end_state const&>(state).start_state())
+				{
+					return invalid_state(state);
+				}
+
+				break;
+
+			default:
+				break;
+			}
+
+			switch (state.state_type())
+			{
+			case atn_state::atn_state_type::block_start:
+			case atn_state::atn_state_type::plus_block_start:
+			case atn_state::atn_state_type::star_block_start:
+				if (!static_cast<block_start_state const&>(state).end_state())
+				{
+					return invalid_state(state);
+				}
+
+				// fall through to the check for every decision state
+			case atn_state::atn_state_type::token_start:
+			case atn_state::atn_state_type::plus_loop_back:
+			case atn_state::atn_state_type::star_loop_entry:
+				if (state.transitions().size() > 1 && static_cast<decision_state const&>(state).decision() == ~static_cast<size_t>(0))
+				{
+					return invalid_state(state);
+				}
+
+				break;
+
+			case atn_state::atn_state_type::rule_stop:
+				break;
+
+			default:
+				if (state.transitions().size() > 1)
+				{
+					return invalid_state(state);
+				}
+
+				break;
+			}
+
+			return std::string();
+		}
+
+	}
+
+	void atn_post_processor::process(grammar_atn& atn, atn_deserialization_options const& options, size_t thread_count)
+	{
+		rule_partition rules = partition(atn);
+
+		// the return transitions are added in the order of the calling rules, whichever thread found them
+		std::vector<std::vector<std::pair<size_t, std::shared_ptr<transition>>>> returns(rules.size());
+		parallel_for(rules.size(), thread_count,
+			[&](size_t rule_index)
+			{
+				link_rule(atn, rules[rule_index], returns[rule_index]);
+			});
+
+		for each (std::vector<std::pair<size_t, std::shared_ptr<transition>>> const& rule_returns in returns)
+		{
+			for each (std::pair<size_t, std::shared_ptr<transition>> const& return_transition in rule_returns)
+			{
+				atn.rule_start_states()[return_transition.first]->stop_state()->add_transition(return_transition.second);
+			}
+		}
+
+		if (options.generate_rule_bypass_transitions() && atn.grammar_type() == atn_type::parser)
+		{
+			generate_rule_bypass_transitions(atn, thread_count);
+		}
+
+		atn_optimizer::optimize(atn, options);
+
+		if (options.verify_atn())
+		{
+			verify(atn, thread_count);
+		}
+	}
+
+	void atn_post_processor::verify(grammar_atn const& atn, size_t thread_count)
+	{
+		rule_partition rules = partition(atn);
+
+		// each rule reports its lowest numbered invalid state, and the lowest of those is thrown
+		const size_t no_error = atn_state::invalid_state_number;
+		std::vector<std::pair<size_t, std::string>> errors(rules.size(), std::make_pair(no_error, std::string()));
+		parallel_for(rules.size(), thread_count,
+			[&](size_t rule_index)
+			{
+				for each (std::shared_ptr<atn_state> const& state in rules[rule_index])
+				{
+					std::string error = verify_state(*state);
+					if (!error.empty())
+					{
+						errors[rule_index] = std::make_pair(state->state_number(), error);
+						break;
+					}
+				}
+			});
+
+		std::pair<size_t, std::string> const& first_error = *std::min_element(errors.begin(), errors.end());
+		if (first_error.first != no_error)
+		{
+			throw std::runtime_error(first_error.second);
+		}
+	}
+
+}
+}
@@ -0,0 +1,33 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstddef>
+
+namespace antlr4 {
+namespace atn {
+
+	class atn_deserialization_options;
+	class grammar_atn;
+
+	// Completes an ATN once its states and transitions have been read: links the states of blocks and loops, adds the
+	// return transitions of rule stop states, marks precedence decisions, generates rule bypass transitions, optimizes
+	// and verifies it, as selected by the options.
+	//
+	// The work which only touches the states of one rule runs on a pool of threads, each taking whole rules. Anything
+	// which crosses rules, adds states or numbers decisions is done afterwards in rule order, so the resulting ATN and
+	// any verification error are the same for every thread count. The optimizer passes read across rules and add states,
+	// so they run on the calling thread.
+	class atn_post_processor
+	{
+	public:
+		// Processes atn using up to thread_count threads, or one per hardware thread if thread_count is zero. Throws
+		// std::runtime_error if verification fails, reporting the lowest numbered invalid state.
+		static void process(grammar_atn& atn, atn_deserialization_options const& options, size_t thread_count = 0);
+
+		// Checks the structural invariants the prediction algorithms rely on. Throws std::runtime_error reporting the
+		// lowest numbered invalid state.
+		static void verify(grammar_atn const& atn, size_t thread_count = 0);
+	};
+
+}
+}
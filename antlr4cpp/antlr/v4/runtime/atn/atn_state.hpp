@@ -6,9 +6,12 @@
 #include <memory>
 #include <vector>
 
+#include "transition_table.hpp"
+
 namespace antlr4 {
 namespace atn {
 
+	class grammar_atn;
 	class transition;
 
 	class atn_state abstract
@@ -42,6 +45,11 @@ namespace atn {
 		std::vector<std::shared_ptr<transition>> _transitions;
 		std::vector<std::shared_ptr<transition>> _optimized_transitions;
 
+		// The entries of this state in the transition table of its ATN, once grammar_atn::build_transition_table has run.
+		transition_table::view _transition_view;
+
+		friend grammar_atn;
+
 	public:
 		static const size_t invalid_state_number = ~static_cast<size_t>(0);
 
@@ -51,6 +59,7 @@ namespace atn {
 			, _state_number(state_number)
 			, _rule_index(rule_index)
 			, _epsilon_only_transitions()
+			, _optimized()
 		{
 		}
 
@@ -100,6 +109,11 @@ namespace atn {
 			return optimized_transitions()[index];
 		}
 
+		transition_table::view const& transition_view() const
+		{
+			return _transition_view;
+		}
+
 		size_t non_stop_state_number() const
 		{
 			return state_type() == atn_state_type::rule_stop ? invalid_state_number : state_number();
@@ -174,6 +188,7 @@ namespace atn {
 		size_t _decision;
 		bool _greedy;
 		bool _sll;
+		bool _ll;
 
 	protected:
 		decision_state(atn_state_type state_type, size_t state_number, size_t rule_index)
@@ -181,6 +196,7 @@ namespace atn {
 			, _decision(~static_cast<size_t>(0))
 			, _greedy(true)
 			, _sll(false)
+			, _ll(false)
 		{
 		}
 
@@ -214,6 +230,17 @@ namespace atn {
 		{
 			_sll = value;
 		}
+
+		// Whether prediction skips SLL for this decision and starts with full-context LL.
+		bool ll() const
+		{
+			return _ll;
+		}
+
+		void ll(bool value)
+		{
+			_ll = value;
+		}
 	};
 
 	class block_start_state abstract : public decision_state
@@ -0,0 +1,530 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <antlr/v4/runtime/atn/binary_atn.hpp>
+
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/lexer_action.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	const misc::uuid binary_atn::feature(0x5C2E8A41u, static_cast<uint16_t>(0x93D7), static_cast<uint16_t>(0x4B1F), 0xA6, 0x0C, 0x7E, 0x39, 0xD2, 0x85, 0x14, 0xFB);
+	const uint32_t binary_atn::version;
+	const size_t binary_atn::alignment;
+
+	// The image starts with the header, followed by these sections, each starting at a multiple of the alignment:
+	//   states                 static_atn::state[state_count]
+	//   transition offsets     uint32_t[state_count + 1]
+	//   transitions            transition_table::entry[transition_count]
+	//   intervals              transition_table::interval[interval_count]
+	//   alternative offsets    uint32_t[state_count + 1], only when alternative_transition_count is not zero
+	//   alternatives           transition_table::entry[alternative_transition_count], the unoptimized transitions
+	//                          when any state was optimized
+	//   alternative intervals  transition_table::interval[alternative_interval_count]
+	//   rule start states      uint32_t[rule_count]
+	//   decision states        uint32_t[decision_count]
+	//   state decisions        uint32_t[state_count], the decision of each state or no_state
+	//   rule state offsets     uint32_t[rule_count + 2]
+	//   rule states            uint32_t[rule state offsets[rule_count + 1]], the states of each rule followed by the
+	//                          states which belong to no rule
+	//   lexer actions          lexer_action_code[lexer_action_count]
+	struct binary_atn::header
+	{
+		misc::uuid feature;
+		uint32_t version;
+		uint32_t byte_order;
+		uint32_t entry_size;
+		atn_type grammar_type;
+		int32_t max_token_type;
+		uint32_t state_count;
+		uint32_t transition_count;
+		uint32_t interval_count;
+		uint32_t alternative_transition_count;
+		uint32_t alternative_interval_count;
+		uint32_t rule_count;
+		uint32_t decision_count;
+		uint32_t lexer_action_count;
+		uint32_t rule_state_count;
+	};
+
+	namespace {
+
+		const uint32_t byte_order_mark = 0x01020304;
+
+		// Whether link, a link of state_number, names no state or a state in the same section of the rule states whose
+		// type is one of types, where no types allows any type.
+		bool linked(static_atn const& arrays, std::vector<size_t> const& sections, size_t state_number, uint32_t link, std::initializer_list<atn_state::atn_state_type> types)
+		{
+			if (link == static_atn::no_state)
+			{
+				return true;
+			}
+
+			if (link >= arrays.state_count || sections[link] != sections[state_number])
+			{
+				return false;
+			}
+
+			return types.size() == 0 || std::find(types.begin(), types.end(), arrays.states[link].type) != types.end();
+		}
+
+		// Whether the offsets of a transition table over state_count states, ending at the number of its entries, keep
+		// every view within the entries, and every entry refers to states of some section and to intervals in range.
+		bool valid_transitions(static_atn const& arrays, std::vector<size_t> const& sections, uint32_t const* offsets, transition_table::entry const* entries, size_t interval_count)
+		{
+			const size_t state_count = arrays.state_count;
+			for (size_t i = 0; i < state_count; i++)
+			{
+				if (offsets[i] > offsets[i + 1])
+				{
+					return false;
+				}
+			}
+
+			for (uint32_t i = 0; i < offsets[state_count]; i++)
+			{
+				transition_table::entry const& entry = entries[i];
+				bool valid = entry.target < state_count && sections[entry.target] != static_atn::no_state;
+				switch (entry.type)
+				{
+				case transition::transition_type::rule:
+					valid = valid
+						&& arrays.states[entry.target].type == atn_state::atn_state_type::rule_start
+						&& entry.first >= 0 && static_cast<size_t>(entry.first) < state_count
+						&& sections[static_cast<size_t>(entry.first)] != static_atn::no_state;
+					break;
+
+				case transition::transition_type::set:
+				case transition::transition_type::not_set:
+					valid = valid
+						&& entry.first >= 0 && entry.first <= entry.second
+						&& static_cast<size_t>(entry.second) <= interval_count;
+					break;
+
+				default:
+					break;
+				}
+
+				if (!valid)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		size_t aligned(size_t size)
+		{
+			return (size + binary_atn::alignment - 1) & ~(binary_atn::alignment - 1);
+		}
+
+		// Reads the sections of an image in order, checking each lies within it.
+		class section_reader
+		{
+		private:
+			uint8_t const* const _data;
+			const size_t _size;
+			size_t _offset;
+
+		public:
+			section_reader(uint8_t const* data, size_t size, size_t offset)
+				: _data(data)
+				, _size(size)
+				, _offset(aligned(offset))
+			{
+			}
+
+		public:
+			template<typename T>
+			T const* read(size_t count)
+			{
+				if (count > (_size - std::min(_offset, _size)) / sizeof(T))
+				{
+					throw std::invalid_argument("The binary ATN image is truncated.");
+				}
+
+				T const* result = reinterpret_cast<T const*>(_data + _offset);
+				_offset = aligned(_offset + count * sizeof(T));
+				return count > 0 ? result : nullptr;
+			}
+		};
+
+		template<typename T>
+		void write_section(std::ostream& out, T const* values, size_t count)
+		{
+			static const char padding[binary_atn::alignment] = {};
+			size_t size = count * sizeof(T);
+			out.write(reinterpret_cast<char const*>(values), static_cast<std::streamsize>(size));
+			out.write(padding, static_cast<std::streamsize>(aligned(size) - size));
+		}
+
+		template<typename T>
+		void write_section(std::ostream& out, std::vector<T> const& values)
+		{
+			write_section(out, values.data(), values.size());
+		}
+
+	}
+
+	binary_atn::binary_atn(void const* data, size_t size)
+	{
+		static_assert(sizeof(header) % alignment == 0, "The binary ATN header must keep the sections aligned.");
+
+		uint8_t const* bytes = static_cast<uint8_t const*>(data);
+		if (reinterpret_cast<uintptr_t>(bytes) % alignment != 0)
+		{
+			throw std::invalid_argument("The binary ATN image is not aligned.");
+		}
+
+		if (size < sizeof(header))
+		{
+			throw std::invalid_argument("The binary ATN image is truncated.");
+		}
+
+		header const& image = *reinterpret_cast<header const*>(bytes);
+		if (!(image.feature == feature) || image.version != version)
+		{
+			throw std::invalid_argument("The binary ATN image is not of a supported format version.");
+		}
+
+		if (image.byte_order != byte_order_mark || image.entry_size != sizeof(transition_table::entry))
+		{
+			throw std::invalid_argument("The binary ATN image was written for another platform.");
+		}
+
+		section_reader reader(bytes, size, sizeof(header));
+		_arrays.grammar_type = image.grammar_type;
+		_arrays.max_token_type = image.max_token_type;
+		_arrays.state_count = image.state_count;
+		_arrays.states = reader.read<static_atn::state>(image.state_count);
+		_arrays.transition_offsets = reader.read<uint32_t>(image.state_count + 1);
+		_arrays.transitions = reader.read<transition_table::entry>(image.transition_count);
+		_arrays.interval_count = image.interval_count;
+		_arrays.intervals = reader.read<transition_table::interval>(image.interval_count);
+		_arrays.alternative_transition_offsets = image.alternative_transition_count > 0 ? reader.read<uint32_t>(image.state_count + 1) : nullptr;
+		_arrays.alternative_transitions = reader.read<transition_table::entry>(image.alternative_transition_count);
+		_arrays.alternative_interval_count = image.alternative_interval_count;
+		_arrays.alternative_intervals = reader.read<transition_table::interval>(image.alternative_interval_count);
+		_arrays.rule_count = image.rule_count;
+		_arrays.rule_start_states = reader.read<uint32_t>(image.rule_count);
+		_arrays.decision_count = image.decision_count;
+		_arrays.decision_states = reader.read<uint32_t>(image.decision_count);
+		_state_decisions = reader.read<uint32_t>(image.state_count);
+		_rule_state_offsets = reader.read<uint32_t>(image.rule_count + 2);
+		_rule_states = reader.read<uint32_t>(image.rule_state_count);
+		_arrays.lexer_action_count = image.lexer_action_count;
+		_arrays.lexer_actions = reader.read<lexer_action_code>(image.lexer_action_count);
+
+		if (_arrays.transition_offsets[image.state_count] != image.transition_count
+			|| (_arrays.alternative_transition_offsets ? _arrays.alternative_transition_offsets[image.state_count] != image.alternative_transition_count : image.alternative_interval_count != 0)
+			|| _rule_state_offsets[image.rule_count + 1] != image.rule_state_count)
+		{
+			throw std::invalid_argument("The binary ATN image is corrupt.");
+		}
+
+		validate();
+
+		// every state starts out null, and is created with its rule
+		_atn.reset(new grammar_atn(_arrays.grammar_type, _arrays.max_token_type));
+		for (size_t i = 0; i < _arrays.state_count; i++)
+		{
+			_atn->add_state(nullptr);
+		}
+
+		for (size_t i = 0; i < _arrays.rule_count; i++)
+		{
+			_atn->add_rule_start_state(nullptr);
+		}
+
+		for (size_t i = 0; i < _arrays.decision_count; i++)
+		{
+			_atn->add_decision_state(nullptr);
+		}
+
+		std::unique_ptr<transition_table> alternative_table;
+		if (_arrays.alternative_transition_offsets)
+		{
+			alternative_table.reset(new transition_table(_arrays.state_count, _arrays.alternative_transition_offsets, _arrays.alternative_transitions, _arrays.alternative_interval_count, _arrays.alternative_intervals));
+		}
+
+		_atn->attach_transition_table(std::unique_ptr<transition_table>(new transition_table(_arrays.state_count, _arrays.transition_offsets, _arrays.transitions, _arrays.interval_count, _arrays.intervals)), std::move(alternative_table));
+		_materialized.reset(new std::atomic<bool>[_arrays.rule_count]());
+		materialize(_arrays.rule_count);
+	}
+
+	binary_atn::~binary_atn()
+	{
+	}
+
+	std::shared_ptr<rule_start_state> const& binary_atn::enter_rule(size_t rule_index)
+	{
+		assert(rule_index < _arrays.rule_count);
+		if (!_materialized[rule_index].load(std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> guard(_materialize_lock);
+			if (!_materialized[rule_index].load(std::memory_order_relaxed))
+			{
+				materialize(rule_index);
+				_materialized[rule_index].store(true, std::memory_order_release);
+			}
+		}
+
+		return _atn->rule_start_states()[rule_index];
+	}
+
+	void binary_atn::validate() const
+	{
+		const size_t state_count = _arrays.state_count;
+		const size_t rule_count = _arrays.rule_count;
+
+		// the section of _rule_states holding each state, where rule_count holds the states which belong to no rule
+		std::vector<size_t> sections(state_count, static_atn::no_state);
+		for (size_t section = 0; section <= rule_count; section++)
+		{
+			if (_rule_state_offsets[section] > _rule_state_offsets[section + 1])
+			{
+				throw std::invalid_argument("The binary ATN image is corrupt.");
+			}
+
+			for (uint32_t i = _rule_state_offsets[section]; i < _rule_state_offsets[section + 1]; i++)
+			{
+				uint32_t state_number = _rule_states[i];
+				if (state_number >= state_count || sections[state_number] != static_atn::no_state)
+				{
+					throw std::invalid_argument("The binary ATN image is corrupt.");
+				}
+
+				static_atn::state const& record = _arrays.states[state_number];
+				if (record.type == atn_state::atn_state_type::invalid
+					|| record.type > atn_state::atn_state_type::loop_end
+					|| (section < rule_count ? record.rule_index != section : record.rule_index < rule_count))
+				{
+					throw std::invalid_argument("The binary ATN image is corrupt.");
+				}
+
+				sections[state_number] = section;
+			}
+		}
+
+		for (size_t i = 0; i < state_count; i++)
+		{
+			static_atn::state const& record = _arrays.states[i];
+			if (sections[i] == static_atn::no_state)
+			{
+				// only unused state numbers belong to no section
+				if (record.type != atn_state::atn_state_type::invalid || _state_decisions[i] != static_atn::no_state)
+				{
+					throw std::invalid_argument("The binary ATN image is corrupt.");
+				}
+
+				continue;
+			}
+
+			// a state is linked to states of its own section, of the types link_state casts them to
+			bool valid = true;
+			switch (record.type)
+			{
+			case atn_state::atn_state_type::block_start:
+			case atn_state::atn_state_type::star_block_start:
+				valid = linked(_arrays, sections, i, record.end_state, { atn_state::atn_state_type::block_end });
+				break;
+
+			case atn_state::atn_state_type::plus_block_start:
+				valid = linked(_arrays, sections, i, record.end_state, { atn_state::atn_state_type::block_end })
+					&& linked(_arrays, sections, i, record.loopback_state, { atn_state::atn_state_type::plus_loop_back });
+				break;
+
+			case atn_state::atn_state_type::block_end:
+				valid = linked(_arrays, sections, i, record.end_state, { atn_state::atn_state_type::block_start, atn_state::atn_state_type::plus_block_start, atn_state::atn_state_type::star_block_start });
+				break;
+
+			case atn_state::atn_state_type::star_loop_entry:
+				valid = linked(_arrays, sections, i, record.loopback_state, { atn_state::atn_state_type::star_loop_back });
+				break;
+
+			case atn_state::atn_state_type::loop_end:
+				valid = linked(_arrays, sections, i, record.loopback_state, {});
+				break;
+
+			case atn_state::atn_state_type::rule_start:
+				valid = linked(_arrays, sections, i, record.end_state, { atn_state::atn_state_type::rule_stop });
+				break;
+
+			default:
+				break;
+			}
+
+			if (!valid)
+			{
+				throw std::invalid_argument("The binary ATN image is corrupt.");
+			}
+
+			if (_state_decisions[i] != static_atn::no_state
+				&& (_state_decisions[i] >= _arrays.decision_count || _arrays.decision_states[_state_decisions[i]] != i))
+			{
+				throw std::invalid_argument("The binary ATN image is corrupt.");
+			}
+		}
+
+		for (size_t i = 0; i < rule_count; i++)
+		{
+			uint32_t state_number = _arrays.rule_start_states[i];
+			if (state_number >= state_count || sections[state_number] != i || _arrays.states[state_number].type != atn_state::atn_state_type::rule_start)
+			{
+				throw std::invalid_argument("The binary ATN image is corrupt.");
+			}
+		}
+
+		for (size_t i = 0; i < _arrays.decision_count; i++)
+		{
+			uint32_t state_number = _arrays.decision_states[i];
+			if (state_number >= state_count || _state_decisions[state_number] != i || !static_atn::decision(_arrays.states[state_number].type))
+			{
+				throw std::invalid_argument("The binary ATN image is corrupt.");
+			}
+		}
+
+		// the offsets end at the transition counts, so offsets which never decrease keep every view within the entries
+		if (!valid_transitions(_arrays, sections, _arrays.transition_offsets, _arrays.transitions, _arrays.interval_count)
+			|| (_arrays.alternative_transition_offsets && !valid_transitions(_arrays, sections, _arrays.alternative_transition_offsets, _arrays.alternative_transitions, _arrays.alternative_interval_count)))
+		{
+			throw std::invalid_argument("The binary ATN image is corrupt.");
+		}
+	}
+
+	void binary_atn::materialize(size_t rule_index)
+	{
+		uint32_t const* begin = _rule_states + _rule_state_offsets[rule_index];
+		uint32_t const* end = _rule_states + _rule_state_offsets[rule_index + 1];
+		for (uint32_t const* state_number = begin; state_number != end; ++state_number)
+		{
+			_atn->set_state(static_atn::create_state(_arrays.states[*state_number], *state_number));
+		}
+
+		// the states a state is linked to always belong to the same rule, as validate checked
+		for (uint32_t const* state_number = begin; state_number != end; ++state_number)
+		{
+			static_atn::link_state(*_atn, _arrays.states[*state_number], *_atn->state(*state_number));
+			if (_state_decisions[*state_number] != static_atn::no_state)
+			{
+				_atn->set_decision_state(_state_decisions[*state_number], std::static_pointer_cast<decision_state>(_atn->state(*state_number)));
+			}
+		}
+
+		if (rule_index < _arrays.rule_count)
+		{
+			_atn->set_rule_start_state(std::static_pointer_cast<rule_start_state>(_atn->state(_arrays.rule_start_states[rule_index])));
+		}
+	}
+
+	void binary_atn::write(std::ostream& out, grammar_atn const& atn, std::vector<std::shared_ptr<lexer_action>> const& lexer_actions)
+	{
+		transition_table const* table = atn.transition_table();
+		assert(table && table->state_count() == atn.states().size());
+		assert(atn.states().size() < std::numeric_limits<uint32_t>::max());
+
+		// the unoptimized transitions, which number the alternatives of the decisions, when any state was optimized
+		transition_table const* alternative_table = atn.alternative_table() != table ? atn.alternative_table() : nullptr;
+
+		std::vector<static_atn::state> states;
+		std::vector<uint32_t> state_decisions(atn.states().size(), static_atn::no_state);
+		// the states of each rule, followed by the states which belong to no rule
+		std::vector<std::vector<uint32_t>> rules(atn.rule_start_states().size() + 1);
+		for each (std::shared_ptr<atn_state> const& state in atn.states())
+		{
+			if (!state)
+			{
+				states.push_back(static_atn::state { atn_state::atn_state_type::invalid, 0, static_atn::no_state, static_atn::no_state, 0 });
+				continue;
+			}
+
+			states.push_back(static_atn::describe(*state));
+			rules[std::min(state->rule_index(), rules.size() - 1)].push_back(static_cast<uint32_t>(state->state_number()));
+		}
+
+		std::vector<uint32_t> rule_start_states;
+		for each (std::shared_ptr<rule_start_state> const& state in atn.rule_start_states())
+		{
+			rule_start_states.push_back(static_cast<uint32_t>(state->state_number()));
+		}
+
+		std::vector<uint32_t> decision_states;
+		for each (std::shared_ptr<decision_state> const& state in atn.decision_states())
+		{
+			state_decisions[state->state_number()] = static_cast<uint32_t>(decision_states.size());
+			decision_states.push_back(static_cast<uint32_t>(state->state_number()));
+		}
+
+		std::vector<uint32_t> rule_state_offsets;
+		std::vector<uint32_t> rule_states;
+		for each (std::vector<uint32_t> const& rule in rules)
+		{
+			rule_state_offsets.push_back(static_cast<uint32_t>(rule_states.size()));
+			rule_states.insert(rule_states.end(), rule.begin(), rule.end());
+		}
+
+		rule_state_offsets.push_back(static_cast<uint32_t>(rule_states.size()));
+
+		std::vector<lexer_action_code> codes;
+		for each (std::shared_ptr<lexer_action> const& action in lexer_actions)
+		{
+			codes.push_back(static_atn::encode(*action));
+		}
+
+		header image = {};
+		image.feature = feature;
+		image.version = version;
+		image.byte_order = byte_order_mark;
+		image.entry_size = sizeof(transition_table::entry);
+		image.grammar_type = atn.grammar_type();
+		image.max_token_type = atn.max_token_type();
+		image.state_count = static_cast<uint32_t>(states.size());
+		image.transition_count = static_cast<uint32_t>(table->size());
+		image.interval_count = static_cast<uint32_t>(table->interval_count());
+		image.alternative_transition_count = alternative_table ? static_cast<uint32_t>(alternative_table->size()) : 0;
+		image.alternative_interval_count = alternative_table ? static_cast<uint32_t>(alternative_table->interval_count()) : 0;
+		image.rule_count = static_cast<uint32_t>(rule_start_states.size());
+		image.decision_count = static_cast<uint32_t>(decision_states.size());
+		image.lexer_action_count = static_cast<uint32_t>(codes.size());
+		image.rule_state_count = static_cast<uint32_t>(rule_states.size());
+
+		write_section(out, &image, 1);
+		write_section(out, states);
+		write_section(out, table->offsets(), table->state_count() + 1);
+		write_section(out, table->entries(), table->size());
+		write_section(out, table->intervals(), table->interval_count());
+		if (alternative_table)
+		{
+			write_section(out, alternative_table->offsets(), alternative_table->state_count() + 1);
+			write_section(out, alternative_table->entries(), alternative_table->size());
+			write_section(out, alternative_table->intervals(), alternative_table->interval_count());
+		}
+		write_section(out, rule_start_states);
+		write_section(out, decision_states);
+		write_section(out, state_decisions);
+		write_section(out, rule_state_offsets);
+		write_section(out, rule_states);
+		write_section(out, codes);
+	}
+
+}
+}
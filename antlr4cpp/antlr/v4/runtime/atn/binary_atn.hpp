@@ -0,0 +1,98 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "../misc/uuid.hpp"
+#include "static_atn.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+	class lexer_action;
+
+	// An ATN in a binary image which is read in place, such as a file mapped into memory. The image holds the arrays of a
+	// static_atn, including the unoptimized transitions which number the alternatives of the decisions, together with an
+	// index of the states of each rule, so the states of a rule are created only when the
+	// rule is first entered; the transitions of every state are viewed directly in the image. States which belong to no
+	// rule, such as the start state of a lexer mode, are created with the binary_atn.
+	//
+	// The image is written in the native layout of the platform writing it. The reader rejects images of another
+	// version of the format, or with another byte order or transition entry size.
+	class binary_atn
+	{
+		binary_atn(binary_atn const&) = delete;
+		binary_atn& operator= (binary_atn const&) = delete;
+
+		struct header;
+
+	public:
+		// Identifies the binary ATN format, as distinct from the serialized ATN read by the deserializer.
+		static const misc::uuid feature;
+		static const uint32_t version = 4;
+
+		// Images are read at this alignment.
+		static const size_t alignment = 8;
+
+	private:
+		static_atn _arrays;
+		uint32_t const* _state_decisions;
+		uint32_t const* _rule_state_offsets;
+		uint32_t const* _rule_states;
+
+		std::unique_ptr<grammar_atn> _atn;
+
+		std::unique_ptr<std::atomic<bool>[]> _materialized;
+		std::mutex _materialize_lock;
+
+	public:
+		// The image at data must remain valid and unchanged for the lifetime of the binary_atn. Throws
+		// std::invalid_argument if it is not an image of this version of the format for this platform, or if any state,
+		// decision or interval it refers to is out of range.
+		binary_atn(void const* data, size_t size);
+		~binary_atn();
+
+	public:
+		// The ATN, where the states of rules which have not been entered are null.
+		grammar_atn const& atn() const
+		{
+			return *_atn;
+		}
+
+		// The arrays of the image. The rule of a state, such as the target of a rule transition, is found through its
+		// record here without creating it.
+		static_atn const& arrays() const
+		{
+			return _arrays;
+		}
+
+		bool materialized(size_t rule_index) const
+		{
+			return _materialized[rule_index].load(std::memory_order_acquire);
+		}
+
+		// Returns the start state of rule_index, creating the states of the rule on its first entry. Safe to call from
+		// multiple threads.
+		std::shared_ptr<rule_start_state> const& enter_rule(size_t rule_index);
+
+	public:
+		// Writes the image of atn, which must have its transition table built.
+		static void write(std::ostream& out, grammar_atn const& atn, std::vector<std::shared_ptr<lexer_action>> const& lexer_actions);
+
+	private:
+		// Checks every reference between the arrays of the image, so that materializing a rule cannot read outside them.
+		void validate() const;
+
+		// Creates the states of rule_index, or of the states which belong to no rule when rule_index is the rule count.
+		void materialize(size_t rule_index);
+	};
+
+}
+}
@@ -0,0 +1,98 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <limits>
+
+#include <antlr/v4/runtime/atn/epsilon_closure_table.hpp>
+
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		// visited holds the generation in which each state was last reached, so it does not need clearing between states
+		void compute_closure(grammar_atn const& atn, uint32_t state_number, std::vector<uint32_t>& visited, uint32_t generation, std::vector<epsilon_closure_table::entry>& entries)
+		{
+			if (visited[state_number] == generation)
+			{
+				return;
+			}
+
+			visited[state_number] = generation;
+
+			// every state is walked, so the states of a binary_atn must all have been materialized
+			assert(atn.state(state_number));
+			if (atn.state(state_number)->state_type() == atn_state::atn_state_type::rule_stop)
+			{
+				entries.push_back(epsilon_closure_table::entry { state_number, true });
+				return;
+			}
+
+			transition_table const& table = *atn.transition_table();
+			if (!table.only_epsilon(state_number))
+			{
+				entries.push_back(epsilon_closure_table::entry { state_number, false });
+				return;
+			}
+
+			for each (transition_table::entry const& transition in table.transitions(state_number))
+			{
+				if (!is_plain_epsilon(transition))
+				{
+					// the order of the closure is preserved by leaving all of the transitions of this state to the runtime
+					entries.push_back(epsilon_closure_table::entry { state_number, true });
+					return;
+				}
+			}
+
+			for each (transition_table::entry const& transition in table.transitions(state_number))
+			{
+				compute_closure(atn, transition.target, visited, generation, entries);
+			}
+		}
+
+	}
+
+	epsilon_closure_table::epsilon_closure_table(grammar_atn const& atn)
+	{
+		assert(atn.transition_table());
+		assert(atn.states().size() < std::numeric_limits<uint32_t>::max());
+
+		std::vector<uint32_t> visited(atn.states().size());
+		_offsets.reserve(atn.states().size() + 1);
+		_context_free.reserve(atn.states().size());
+		for each (std::shared_ptr<atn_state> const& state in atn.states())
+		{
+			size_t offset = _entries.size();
+			_offsets.push_back(static_cast<uint32_t>(offset));
+			if (state)
+			{
+				compute_closure(atn, static_cast<uint32_t>(state->state_number()), visited, static_cast<uint32_t>(_offsets.size()), _entries);
+			}
+
+			bool context_free = true;
+			for (size_t i = offset; i < _entries.size(); i++)
+			{
+				context_free &= !_entries[i].context_sensitive;
+			}
+
+			_context_free.push_back(context_free);
+		}
+
+		assert(_entries.size() < std::numeric_limits<uint32_t>::max());
+		_offsets.push_back(static_cast<uint32_t>(_entries.size()));
+	}
+
+}
+}
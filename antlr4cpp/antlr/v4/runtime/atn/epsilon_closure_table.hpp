@@ -0,0 +1,96 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+
+	// The context-free part of the epsilon closure of every state of an ATN, computed once so closure does not have to
+	// walk chains of epsilon transitions on every visit.
+	//
+	// The closure of a state lists, in the order a recursive closure would reach them, the states reachable through
+	// plain epsilon transitions which either have transitions consuming input, or need the runtime to continue the
+	// closure from them. The latter are rule stop states, whose successors depend on the prediction context, and states
+	// with a rule, predicate, precedence or action transition, or an epsilon transition leaving a precedence rule. The
+	// runtime continues the closure of such a state as if it had reached it directly.
+	class epsilon_closure_table
+	{
+		epsilon_closure_table(epsilon_closure_table const&) = delete;
+		epsilon_closure_table& operator= (epsilon_closure_table const&) = delete;
+
+	public:
+		struct entry
+		{
+			uint32_t state;
+			bool context_sensitive;
+		};
+
+		// A non-owning view of the closure of one state.
+		class view
+		{
+		private:
+			entry const* _begin;
+			entry const* _end;
+
+		public:
+			view(entry const* begin, entry const* end)
+				: _begin(begin)
+				, _end(end)
+			{
+			}
+
+		public:
+			entry const* begin() const
+			{
+				return _begin;
+			}
+
+			entry const* end() const
+			{
+				return _end;
+			}
+
+			size_t size() const
+			{
+				return static_cast<size_t>(_end - _begin);
+			}
+
+			entry const& operator[] (size_t index) const
+			{
+				assert(index < size());
+				return _begin[index];
+			}
+		};
+
+	private:
+		std::vector<uint32_t> _offsets;
+		std::vector<entry> _entries;
+
+		// Whether the closure of each state is free of context-sensitive entries.
+		std::vector<bool> _context_free;
+
+	public:
+		// Computes the closures from the transition table of a finished ATN, which must have been built.
+		explicit epsilon_closure_table(grammar_atn const& atn);
+
+	public:
+		view closure(uint32_t state_number) const
+		{
+			assert(state_number + 1 < _offsets.size());
+			return view(_entries.data() + _offsets[state_number], _entries.data() + _offsets[state_number + 1]);
+		}
+
+		bool context_free(uint32_t state_number) const
+		{
+			return _context_free[state_number];
+		}
+	};
+
+}
+}
@@ -0,0 +1,121 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+
+#include <antlr/v4/runtime/atn/transition.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	grammar_atn::~grammar_atn()
+	{
+		for each (std::shared_ptr<atn_state> const& state in _states)
+		{
+			if (!state)
+			{
+				continue;
+			}
+
+			state->_transitions.clear();
+			state->_optimized_transitions.clear();
+			state->_transition_view = transition_table::view();
+
+			switch (state->state_type())
+			{
+			case atn_state::atn_state_type::block_start:
+			case atn_state::atn_state_type::star_block_start:
+				static_cast<block_start_state&>(*state).end_state(nullptr);
+				break;
+
+			case atn_state::atn_state_type::plus_block_start:
+				static_cast<plus_block_start_state&>(*state).end_state(nullptr);
+				static_cast<plus_block_start_state&>(*state).loopback_state(nullptr);
+				break;
+
+			case atn_state::atn_state_type::block_end:
+				static_cast<block_end_state&>(*state).start_state(nullptr);
+				break;
+
+			case atn_state::atn_state_type::star_loop_entry:
+				static_cast<star_loop_entry_state&>(*state).loopback_state(nullptr);
+				break;
+
+			case atn_state::atn_state_type::loop_end:
+				static_cast<loop_end_state&>(*state).loopback_state(nullptr);
+				break;
+
+			case atn_state::atn_state_type::rule_start:
+				static_cast<rule_start_state&>(*state).stop_state(nullptr);
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	void grammar_atn::build_transition_table()
+	{
+		std::unique_ptr<atn::transition_table> alternative_table;
+		if (std::any_of(_states.begin(), _states.end(),
+			[](std::shared_ptr<atn_state> const& state)
+			{
+				return state && state->optimized();
+			}))
+		{
+			alternative_table.reset(new atn::transition_table(*this, atn::transition_table::transition_list::alternatives));
+		}
+
+		attach_transition_table(std::unique_ptr<atn::transition_table>(new atn::transition_table(*this)), std::move(alternative_table));
+	}
+
+	void grammar_atn::set_state(std::shared_ptr<atn_state> const& state)
+	{
+		assert(!_states[state->state_number()]);
+		_states[state->state_number()] = state;
+		if (_transition_table)
+		{
+			attach_transition_view(*state);
+		}
+	}
+
+	void grammar_atn::attach_transition_table(std::unique_ptr<atn::transition_table>&& table, std::unique_ptr<atn::transition_table>&& alternative_table)
+	{
+		assert(table->state_count() == _states.size());
+		assert(!alternative_table || alternative_table->state_count() == _states.size());
+
+		_transition_table = std::move(table);
+		_alternative_table = std::move(alternative_table);
+		for each (std::shared_ptr<atn_state> const& state in _states)
+		{
+			if (state)
+			{
+				attach_transition_view(*state);
+			}
+		}
+	}
+
+	void grammar_atn::attach_transition_view(atn_state& state) const
+	{
+		state._transition_view = _transition_table->transitions(static_cast<uint32_t>(state.state_number()));
+		if (state._transitions.empty() && !state._transition_view.empty())
+		{
+			state._epsilon_only_transitions = std::all_of(state._transition_view.begin(), state._transition_view.end(),
+				[](transition_table::entry const& entry)
+				{
+					return transition::epsilon(entry.type);
+				});
+		}
+	}
+
+}
+}
@@ -0,0 +1,143 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "atn_state.hpp"
+#include "atn_type.hpp"
+#include "transition_table.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn
+	{
+		grammar_atn(grammar_atn const&) = delete;
+		grammar_atn& operator= (grammar_atn const&) = delete;
+
+	private:
+		const atn_type _grammar_type;
+		const int32_t _max_token_type;
+
+		std::vector<std::shared_ptr<atn_state>> _states;
+		std::vector<std::shared_ptr<rule_start_state>> _rule_start_states;
+		std::vector<std::shared_ptr<decision_state>> _decision_states;
+		std::unique_ptr<atn::transition_table> _transition_table;
+		std::unique_ptr<atn::transition_table> _alternative_table;
+
+	public:
+		grammar_atn(atn_type grammar_type, int32_t max_token_type)
+			: _grammar_type(grammar_type)
+			, _max_token_type(max_token_type)
+		{
+		}
+
+		// States refer to each other through their transitions and through the links between the states of a block or
+		// loop, so the destructor breaks these references for the states to be released.
+		~grammar_atn();
+
+	public:
+		atn_type grammar_type() const
+		{
+			return _grammar_type;
+		}
+
+		int32_t max_token_type() const
+		{
+			return _max_token_type;
+		}
+
+		std::vector<std::shared_ptr<atn_state>> const& states() const
+		{
+			return _states;
+		}
+
+		std::shared_ptr<atn_state> const& state(size_t state_number) const
+		{
+			return _states[state_number];
+		}
+
+		// The start state of each rule, indexed by rule index.
+		std::vector<std::shared_ptr<rule_start_state>> const& rule_start_states() const
+		{
+			return _rule_start_states;
+		}
+
+		// The state of each decision, indexed by decision number.
+		std::vector<std::shared_ptr<decision_state>> const& decision_states() const
+		{
+			return _decision_states;
+		}
+
+		// The transition table built by build_transition_table, or null if it has not been built.
+		atn::transition_table const* transition_table() const
+		{
+			return _transition_table.get();
+		}
+
+		// The table of the transitions as the grammar defines them, which the static analyses walk. This is the
+		// transition table itself when no state was optimized.
+		atn::transition_table const* alternative_table() const
+		{
+			return _alternative_table ? _alternative_table.get() : _transition_table.get();
+		}
+
+	public:
+		void add_state(std::shared_ptr<atn_state> const& state)
+		{
+			assert(!state || state->state_number() == _states.size());
+			_states.push_back(state);
+		}
+
+		void add_rule_start_state(std::shared_ptr<rule_start_state> const& state)
+		{
+			assert(!state || state->rule_index() == _rule_start_states.size());
+			_rule_start_states.push_back(state);
+		}
+
+		// Assigns the next decision number to state. A null state reserves the number for a state set later.
+		void add_decision_state(std::shared_ptr<decision_state> const& state)
+		{
+			if (state)
+			{
+				state->decision(_decision_states.size());
+			}
+
+			_decision_states.push_back(state);
+		}
+
+		// Fills the slot of a state which was added as null, for an ATN whose states are created on demand. The state
+		// takes its view from the transition table if one is attached.
+		void set_state(std::shared_ptr<atn_state> const& state);
+
+		void set_rule_start_state(std::shared_ptr<rule_start_state> const& state)
+		{
+			assert(!_rule_start_states[state->rule_index()]);
+			_rule_start_states[state->rule_index()] = state;
+		}
+
+		void set_decision_state(size_t decision, std::shared_ptr<decision_state> const& state)
+		{
+			assert(!_decision_states[decision]);
+			state->decision(decision);
+			_decision_states[decision] = state;
+		}
+
+		// Stores the transitions of every state contiguously, and points the transition view of each state at its
+		// entries. This is done once the ATN is complete, after deserialization and optimization.
+		void build_transition_table();
+
+		// Makes table the transition table of the ATN and points the transition view of each state at its entries. States
+		// without transition objects, as read from a static_atn or binary_atn, take their epsilon-only flag from the table.
+		// alternative_table, if not null, holds the transitions as the grammar defines them where they differ.
+		void attach_transition_table(std::unique_ptr<atn::transition_table>&& table, std::unique_ptr<atn::transition_table>&& alternative_table = nullptr);
+
+	private:
+		void attach_transition_view(atn_state& state) const;
+	};
+
+}
+}
@@ -1,9 +1,18 @@
 // Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
 #include "stdafx.h"
 
+#include <cassert>
 #include <stdexcept>
 
 #include <antlr/v4/runtime/atn/lexer_action.hpp>
+#include <antlr/v4/runtime/misc/murmur_hash.hpp>
+#include <antlr/v4/runtime/misc/param_type.hpp>
+#include <antlr/v4/runtime/misc/ptr_hash.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
 
 namespace antlr4 {
 namespace atn {
@@ -72,9 +81,58 @@ namespace atn {
 	{
 	}
 
-	bool operator== (lexer_action const& /*x*/, lexer_action const& /*y*/)
+	bool operator== (lexer_action const& x, lexer_action const& y)
 	{
-		throw std::runtime_error("not implemented");
+		if (&x == &y)
+		{
+			return true;
+		}
+
+		if (x.action_type() != y.action_type())
+		{
+			return false;
+		}
+
+		switch (x.action_type())
+		{
+		case lexer_action::lexer_action_type::channel:
+			return static_cast<lexer_action::channel_action const&>(x).channel() == static_cast<lexer_action::channel_action const&>(y).channel();
+
+		case lexer_action::lexer_action_type::mode:
+			return static_cast<lexer_action::mode_action const&>(x).mode() == static_cast<lexer_action::mode_action const&>(y).mode();
+
+		case lexer_action::lexer_action_type::push_mode:
+			return static_cast<lexer_action::push_mode_action const&>(x).mode() == static_cast<lexer_action::push_mode_action const&>(y).mode();
+
+		case lexer_action::lexer_action_type::type:
+			return static_cast<lexer_action::type_action const&>(x).type() == static_cast<lexer_action::type_action const&>(y).type();
+
+		case lexer_action::lexer_action_type::more:
+		case lexer_action::lexer_action_type::pop_mode:
+		case lexer_action::lexer_action_type::skip:
+			// these actions have no parameters
+			return true;
+
+		case lexer_action::lexer_action_type::custom:
+		{
+			lexer_action::custom_action const& left = static_cast<lexer_action::custom_action const&>(x);
+			lexer_action::custom_action const& right = static_cast<lexer_action::custom_action const&>(y);
+			return left.rule_index() == right.rule_index()
+				&& left.action_index() == right.action_index();
+		}
+
+		case lexer_action::lexer_action_type::indexed_custom:
+		{
+			lexer_action::indexed_custom_action const& left = static_cast<lexer_action::indexed_custom_action const&>(x);
+			lexer_action::indexed_custom_action const& right = static_cast<lexer_action::indexed_custom_action const&>(y);
+			return left.offset() == right.offset()
+				&& *left.action() == *right.action();
+		}
+
+		default:
+			assert(!"Invalid lexer action type.");
+			return false;
+		}
 	}
 
 }
@@ -83,10 +141,55 @@ namespace atn {
 namespace std {
 
 	using namespace antlr4::atn;
+	using namespace antlr4::misc;
 
-	size_t hash<lexer_action>::operator() (lexer_action const& /*action*/) const
+	size_t hash<lexer_action>::operator() (lexer_action const& action) const
 	{
-		throw std::runtime_error("not implemented");
-	};
+		int32_t hash = murmur_hash::initialize();
+		hash = murmur_hash::update(hash, static_cast<int32_t>(action.action_type()));
+		switch (action.action_type())
+		{
+		case lexer_action::lexer_action_type::channel:
+			hash = murmur_hash::update(hash, static_cast<lexer_action::channel_action const&>(action).channel());
+			return static_cast<size_t>(murmur_hash::finish(hash, 2));
+
+		case lexer_action::lexer_action_type::mode:
+			hash = murmur_hash::update(hash, static_cast<lexer_action::mode_action const&>(action).mode());
+			return static_cast<size_t>(murmur_hash::finish(hash, 2));
+
+		case lexer_action::lexer_action_type::push_mode:
+			hash = murmur_hash::update(hash, static_cast<lexer_action::push_mode_action const&>(action).mode());
+			return static_cast<size_t>(murmur_hash::finish(hash, 2));
+
+		case lexer_action::lexer_action_type::type:
+			hash = murmur_hash::update(hash, static_cast<lexer_action::type_action const&>(action).type());
+			return static_cast<size_t>(murmur_hash::finish(hash, 2));
+
+		case lexer_action::lexer_action_type::more:
+		case lexer_action::lexer_action_type::pop_mode:
+		case lexer_action::lexer_action_type::skip:
+			return static_cast<size_t>(murmur_hash::finish(hash, 1));
+
+		case lexer_action::lexer_action_type::custom:
+		{
+			lexer_action::custom_action const& custom = static_cast<lexer_action::custom_action const&>(action);
+			hash = murmur_hash::update(hash, static_cast<int32_t>(custom.rule_index()));
+			hash = murmur_hash::update(hash, static_cast<int32_t>(custom.action_index()));
+			return static_cast<size_t>(murmur_hash::finish(hash, 3));
+		}
+
+		case lexer_action::lexer_action_type::indexed_custom:
+		{
+			lexer_action::indexed_custom_action const& indexed = static_cast<lexer_action::indexed_custom_action const&>(action);
+			hash = murmur_hash::update(hash, static_cast<int32_t>(indexed.offset()));
+			hash = murmur_hash::update(hash, indexed.action(), ptr_hash<std::shared_ptr<lexer_action>>());
+			return static_cast<size_t>(murmur_hash::finish(hash, 3));
+		}
+
+		default:
+			assert(!"Invalid lexer action type.");
+			return 0;
+		}
+	}
 
 }
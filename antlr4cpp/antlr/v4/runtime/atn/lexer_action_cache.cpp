@@ -0,0 +1,90 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <atomic>
+
+#include <antlr/v4/runtime/atn/lexer_action.hpp>
+#include <antlr/v4/runtime/atn/lexer_action_cache.hpp>
+#include <antlr/v4/runtime/misc/unordered_ptr_set.hpp>
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		std::atomic<size_t> next_id(0);
+
+	}
+
+	class lexer_action_cache::data
+	{
+		data(data const&) = delete;
+		data& operator= (data const&) = delete;
+
+	public:
+		const size_t id;
+		misc::unordered_ptr_set<std::shared_ptr<lexer_action>> actions;
+
+	public:
+		data()
+			: id(++next_id)
+		{
+			// the parameterless actions already have shared instances
+			actions.insert(lexer_action::more_action::instance);
+			actions.insert(lexer_action::pop_mode_action::instance);
+			actions.insert(lexer_action::skip_action::instance);
+		}
+	};
+
+	lexer_action_cache::lexer_action_cache(bool enable_cache)
+		: private_data(enable_cache ? std::move(std::make_unique<lexer_action_cache::data>()) : nullptr)
+	{
+	}
+
+	lexer_action_cache::lexer_action_cache(lexer_action_cache && cache)
+		: private_data(std::move(cache.private_data))
+	{
+	}
+
+	lexer_action_cache::~lexer_action_cache()
+	{
+	}
+
+	lexer_action_cache lexer_action_cache::uncached()
+	{
+		return lexer_action_cache(false);
+	}
+
+	size_t lexer_action_cache::size() const
+	{
+		return private_data ? private_data->actions.size() : 0;
+	}
+
+	size_t lexer_action_cache::id() const
+	{
+		return private_data ? private_data->id : 0;
+	}
+
+	std::shared_ptr<lexer_action> lexer_action_cache::get_as_cached(std::shared_ptr<lexer_action> const& action)
+	{
+		if (!private_data || !action)
+		{
+			return action;
+		}
+
+		if (action->action_type() == lexer_action::lexer_action_type::indexed_custom)
+		{
+			// intern the wrapped action first, so equal wrappers also share the action they wrap
+			lexer_action::indexed_custom_action const& indexed = static_cast<lexer_action::indexed_custom_action const&>(*action);
+			std::shared_ptr<lexer_action> wrapped = get_as_cached(indexed.action());
+			if (wrapped != indexed.action())
+			{
+				return *private_data->actions.insert(std::make_shared<lexer_action::indexed_custom_action>(indexed.offset(), wrapped)).first;
+			}
+		}
+
+		return *private_data->actions.insert(action).first;
+	}
+
+}
+}
@@ -0,0 +1,43 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <memory>
+
+namespace antlr4 {
+namespace atn {
+
+	class lexer_action;
+
+	// Interns lexer actions so that equal actions, such as every channel_action for the hidden channel, share a single
+	// instance. Lexer action executors built from interned actions can then be compared element by element with a
+	// pointer comparison.
+	class lexer_action_cache
+	{
+		class data;
+
+		lexer_action_cache(lexer_action_cache const&) = delete;
+		lexer_action_cache& operator= (lexer_action_cache const&) = delete;
+
+	private:
+		std::unique_ptr<data> private_data;
+
+	public:
+		lexer_action_cache(bool enable_cache = true);
+		lexer_action_cache(lexer_action_cache&& cache);
+		~lexer_action_cache();
+
+	public:
+		static lexer_action_cache uncached();
+
+	public:
+		size_t size() const;
+
+		// Distinguishes this cache from every other cache created by the process, for memos of interned results which
+		// must not be returned to users of a different cache. The id of an uncached instance is 0.
+		size_t id() const;
+
+		std::shared_ptr<lexer_action> get_as_cached(std::shared_ptr<lexer_action> const& action);
+	};
+
+}
+}
@@ -0,0 +1,22 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstdint>
+
+#include "lexer_action.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	// A lexer action encoded as a value. The operand holds the channel, mode or type of the position-independent actions
+	// which carry one; for custom and indexed custom actions it is an index into a side table of the owning executor.
+	struct lexer_action_code
+	{
+		lexer_action::lexer_action_type type;
+		int32_t operand;
+	};
+
+	static_assert(sizeof(lexer_action_code) == 8, "lexer_action_code is expected to pack into 8 bytes");
+
+}
+}
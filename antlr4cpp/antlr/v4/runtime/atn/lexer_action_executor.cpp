@@ -1,15 +1,24 @@
 // Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
 #include "stdafx.h"
 
+#include <cassert>
 #include <iterator>
 
 #include <antlr/v4/runtime/atn/lexer_action_executor.hpp>
 
 #include <antlr/v4/runtime/atn/lexer_action.hpp>
+#include <antlr/v4/runtime/atn/lexer_action_cache.hpp>
+#include <antlr/v4/runtime/atn/lexer_action_target.hpp>
+#include <antlr/v4/runtime/atn/lexer_custom_action_table.hpp>
 #include <antlr/v4/runtime/misc/murmur_hash.hpp>
 #include <antlr/v4/runtime/misc/ptr_equal_to.hpp>
 #include <antlr/v4/runtime/misc/ptr_hash.hpp>
 
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
 namespace antlr4 {
 namespace atn {
 
@@ -17,7 +26,7 @@ namespace atn {
 
 	namespace {
 
-		size_t calculate_hash_code(std::vector<std::shared_ptr<lexer_action>> const& actions)
+		int32_t calculate_partial_hash_code(std::vector<std::shared_ptr<lexer_action>> const& actions)
 		{
 			int32_t hash = murmur_hash::initialize();
 			for each (std::shared_ptr<lexer_action> action in actions)
@@ -25,15 +34,264 @@ namespace atn {
 				hash = murmur_hash::update(hash, action, ptr_hash<std::shared_ptr<lexer_action>>());
 			}
 
-			return static_cast<size_t>(murmur_hash::finish(hash, actions.size()));
+			return hash;
+		}
+
+		lexer_action_code encode(lexer_action const& action, std::vector<std::shared_ptr<lexer_action>>& position_dependent_actions, std::shared_ptr<lexer_action> const& shared_action)
+		{
+			switch (action.action_type())
+			{
+			case lexer_action::lexer_action_type::channel:
+				return lexer_action_code { action.action_type(), static_cast<lexer_action::channel_action const&>(action).channel() };
+
+			case lexer_action::lexer_action_type::mode:
+				return lexer_action_code { action.action_type(), static_cast<lexer_action::mode_action const&>(action).mode() };
+
+			case lexer_action::lexer_action_type::push_mode:
+				return lexer_action_code { action.action_type(), static_cast<lexer_action::push_mode_action const&>(action).mode() };
+
+			case lexer_action::lexer_action_type::type:
+				return lexer_action_code { action.action_type(), static_cast<lexer_action::type_action const&>(action).type() };
+
+			case lexer_action::lexer_action_type::more:
+			case lexer_action::lexer_action_type::pop_mode:
+			case lexer_action::lexer_action_type::skip:
+				return lexer_action_code { action.action_type(), 0 };
+
+			case lexer_action::lexer_action_type::custom:
+			case lexer_action::lexer_action_type::indexed_custom:
+				position_dependent_actions.push_back(shared_action);
+				return lexer_action_code { action.action_type(), static_cast<int32_t>(position_dependent_actions.size() - 1) };
+
+			default:
+				assert(!"Invalid lexer action type.");
+				return lexer_action_code { action.action_type(), 0 };
+			}
+		}
+
+		// Reduces a sequence of position-independent actions to its net effect. More, skip and type all assign the token
+		// type so only the last of them matters, only the last channel matters, and the mode stack operations reduce to
+		// some number of pops followed by an optional mode change and the pushes which were not popped again.
+		std::vector<lexer_action_code> net_effect(std::vector<lexer_action_code> const& codes)
+		{
+			const lexer_action_code none = { lexer_action::lexer_action_type::custom, 0 };
+			lexer_action_code type = none;
+			lexer_action_code channel = none;
+			lexer_action_code mode = none;
+			size_t pops = 0;
+			std::vector<int32_t> pushes;
+			for each (lexer_action_code code in codes)
+			{
+				switch (code.type)
+				{
+				case lexer_action::lexer_action_type::channel:
+					channel = code;
+					break;
+
+				case lexer_action::lexer_action_type::more:
+				case lexer_action::lexer_action_type::skip:
+				case lexer_action::lexer_action_type::type:
+					type = code;
+					break;
+
+				case lexer_action::lexer_action_type::mode:
+					if (!pushes.empty())
+					{
+						// push_mode(x) followed by mode(y) leaves the same stack as push_mode(y)
+						pushes.back() = code.operand;
+					}
+					else
+					{
+						mode = code;
+					}
+
+					break;
+
+				case lexer_action::lexer_action_type::push_mode:
+					pushes.push_back(code.operand);
+					break;
+
+				case lexer_action::lexer_action_type::pop_mode:
+					if (!pushes.empty())
+					{
+						pushes.pop_back();
+					}
+					else
+					{
+						// the pop replaces any mode set since the previous pop
+						mode = none;
+						pops++;
+					}
+
+					break;
+
+				default:
+					assert(!"Invalid lexer action type.");
+					break;
+				}
+			}
+
+			std::vector<lexer_action_code> result;
+			if (type.type != none.type)
+			{
+				result.push_back(type);
+			}
+
+			if (channel.type != none.type)
+			{
+				result.push_back(channel);
+			}
+
+			result.insert(result.end(), pops, lexer_action_code { lexer_action::lexer_action_type::pop_mode, 0 });
+			if (mode.type != none.type)
+			{
+				result.push_back(mode);
+			}
+
+			for each (int32_t push in pushes)
+			{
+				result.push_back(lexer_action_code { lexer_action::lexer_action_type::push_mode, push });
+			}
+
+			return result;
+		}
+
+		lexer_action::custom_action const& as_custom(lexer_action const& action)
+		{
+			assert(action.action_type() == lexer_action::lexer_action_type::custom);
+			return static_cast<lexer_action::custom_action const&>(action);
 		}
 
+		struct virtual_dispatcher
+		{
+			void operator() (lexer_action::custom_action const& action, lexer_action_target& target) const
+			{
+				target.action(action.rule_index(), action.action_index());
+			}
+		};
+
+		struct table_dispatcher
+		{
+			lexer_custom_action_table const& table;
+
+			void operator() (lexer_action::custom_action const& action, lexer_action_target& target) const
+			{
+				table.execute(action, target);
+			}
+		};
+
 	}
 
 	lexer_action_executor::lexer_action_executor(std::vector<std::shared_ptr<lexer_action>>&& actions)
-		: _actions(actions)
-		, _hash_code(calculate_hash_code(_actions))
+		: lexer_action_executor(std::move(actions), calculate_partial_hash_code(actions))
+	{
+	}
+
+	lexer_action_executor::lexer_action_executor(std::vector<std::shared_ptr<lexer_action>>&& actions, int32_t partial_hash_code)
+		: _actions(std::move(actions))
+		, _partial_hash_code(partial_hash_code)
+		, _hash_code(static_cast<size_t>(murmur_hash::finish(partial_hash_code, _actions.size())))
+	{
+		_codes.reserve(_actions.size());
+		for each (std::shared_ptr<lexer_action> const& action in _actions)
+		{
+			_codes.push_back(encode(*action, _position_dependent_actions, action));
+		}
+
+		if (_position_dependent_actions.empty())
+		{
+			// Without custom actions nothing can observe the intermediate states of the lexer, so only the net effect of
+			// the actions needs to be applied when a token is accepted.
+			_codes = net_effect(_codes);
+		}
+	}
+
+	void lexer_action_executor::execute(lexer_action_target& target, size_t start_index) const
+	{
+		run(target, start_index, virtual_dispatcher());
+	}
+
+	void lexer_action_executor::execute(lexer_action_target& target, size_t start_index, lexer_custom_action_table const& table) const
 	{
+		run(target, start_index, table_dispatcher { table });
+	}
+
+	template<typename CustomActionDispatcher>
+	void lexer_action_executor::run(lexer_action_target& target, size_t start_index, CustomActionDispatcher const& dispatcher) const
+	{
+		bool requires_seek = false;
+		size_t stop_index = target.index();
+		try
+		{
+			for each (lexer_action_code code in _codes)
+			{
+				switch (code.type)
+				{
+				case lexer_action::lexer_action_type::channel:
+					target.channel(code.operand);
+					break;
+
+				case lexer_action::lexer_action_type::mode:
+					target.mode(code.operand);
+					break;
+
+				case lexer_action::lexer_action_type::more:
+					target.more();
+					break;
+
+				case lexer_action::lexer_action_type::pop_mode:
+					target.pop_mode();
+					break;
+
+				case lexer_action::lexer_action_type::push_mode:
+					target.push_mode(code.operand);
+					break;
+
+				case lexer_action::lexer_action_type::skip:
+					target.skip();
+					break;
+
+				case lexer_action::lexer_action_type::type:
+					target.type(code.operand);
+					break;
+
+				case lexer_action::lexer_action_type::custom:
+					// position-dependent actions which were not given an offset are executed at the end of the token
+					target.seek(stop_index);
+					requires_seek = false;
+					dispatcher(as_custom(*_position_dependent_actions[code.operand]), target);
+					break;
+
+				case lexer_action::lexer_action_type::indexed_custom:
+					{
+						lexer_action::indexed_custom_action const& indexed = static_cast<lexer_action::indexed_custom_action const&>(*_position_dependent_actions[code.operand]);
+						target.seek(start_index + indexed.offset());
+						requires_seek = start_index + indexed.offset() != stop_index;
+						dispatcher(as_custom(*indexed.action()), target);
+					}
+
+					break;
+
+				default:
+					assert(!"Invalid lexer action type.");
+					break;
+				}
+			}
+		}
+		catch (...)
+		{
+			if (requires_seek)
+			{
+				target.seek(stop_index);
+			}
+
+			throw;
+		}
+
+		if (requires_seek)
+		{
+			target.seek(stop_index);
+		}
 	}
 
 	std::shared_ptr<lexer_action_executor> lexer_action_executor::append(std::shared_ptr<lexer_action_executor> const& executor, std::shared_ptr<lexer_action> const& action)
@@ -43,35 +301,68 @@ namespace atn {
 			return std::make_shared<lexer_action_executor>(std::vector<std::shared_ptr<lexer_action>> { action });
 		}
 
+		std::lock_guard<std::mutex> guard(executor->_extensions_lock);
+		for each (auto const& extension in executor->_extensions)
+		{
+			if (extension.first == action || *extension.first == *action)
+			{
+				return extension.second;
+			}
+		}
+
 		std::vector<std::shared_ptr<lexer_action>> actions;
 		actions.reserve(executor->actions().size() + 1);
 		std::copy(executor->actions().begin(), executor->actions().end(), std::back_inserter(actions));
 		actions.push_back(action);
-		return std::make_shared<lexer_action_executor>(std::move(actions));
+
+		int32_t partial_hash_code = murmur_hash::update(executor->_partial_hash_code, action, ptr_hash<std::shared_ptr<lexer_action>>());
+		std::shared_ptr<lexer_action_executor> result(new lexer_action_executor(std::move(actions), partial_hash_code));
+		executor->_extensions.push_back(std::make_pair(action, result));
+		return result;
 	}
 
 	std::shared_ptr<lexer_action_executor> lexer_action_executor::fix_offset_before_match(std::shared_ptr<lexer_action_executor> const& executor, size_t offset)
 	{
-		std::vector<std::shared_ptr<lexer_action>> updated_actions;
-		for (size_t i = 0; i < executor->actions().size(); i++)
+		lexer_action_cache action_cache(lexer_action_cache::uncached());
+		return fix_offset_before_match(executor, offset, action_cache);
+	}
+
+	std::shared_ptr<lexer_action_executor> lexer_action_executor::fix_offset_before_match(std::shared_ptr<lexer_action_executor> const& executor, size_t offset, lexer_action_cache& action_cache)
+	{
+		bool requires_offset = false;
+		for each (std::shared_ptr<lexer_action> const& action in executor->_position_dependent_actions)
 		{
-			if (executor->actions()[i]->position_dependent() && executor->actions()[i]->action_type() != lexer_action::lexer_action_type::indexed_custom)
+			if (action->action_type() != lexer_action::lexer_action_type::indexed_custom)
 			{
-				if (updated_actions.empty())
-				{
-					updated_actions.insert(updated_actions.end(), executor->actions().begin(), executor->actions().end());
-				}
-
-				updated_actions[i] = std::make_shared<lexer_action::indexed_custom_action>(offset, updated_actions[i]);
+				requires_offset = true;
+				break;
 			}
 		}
 
-		if (updated_actions.empty())
+		if (!requires_offset)
 		{
 			return executor;
 		}
 
-		return std::make_shared<lexer_action_executor>(std::move(updated_actions));
+		std::lock_guard<std::mutex> guard(executor->_extensions_lock);
+		offset_fix& fixed = executor->_offset_fixes[offset % offset_fix_slots];
+		if (fixed.executor && fixed.offset == offset && fixed.cache_id == action_cache.id())
+		{
+			return fixed.executor;
+		}
+
+		std::vector<std::shared_ptr<lexer_action>> updated_actions(executor->actions());
+		for (size_t i = 0; i < updated_actions.size(); i++)
+		{
+			if (updated_actions[i]->position_dependent() && updated_actions[i]->action_type() != lexer_action::lexer_action_type::indexed_custom)
+			{
+				updated_actions[i] = action_cache.get_as_cached(std::make_shared<lexer_action::indexed_custom_action>(offset, updated_actions[i]));
+			}
+		}
+
+		std::shared_ptr<lexer_action_executor> result = std::make_shared<lexer_action_executor>(std::move(updated_actions));
+		fixed = offset_fix { offset, action_cache.id(), result };
+		return result;
 	}
 
 	bool operator==(lexer_action_executor const& x, lexer_action_executor const& y)
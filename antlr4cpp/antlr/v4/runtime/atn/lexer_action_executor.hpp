@@ -2,34 +2,98 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
+#include "lexer_action_code.hpp"
+
 namespace antlr4 {
 namespace atn {
 
 	class lexer_action;
+	class lexer_action_cache;
+	class lexer_action_target;
+	class lexer_custom_action_table;
 
 	class lexer_action_executor
 	{
+		lexer_action_executor(lexer_action_executor const&) = delete;
+		lexer_action_executor& operator= (lexer_action_executor const&) = delete;
+
 	private:
 		std::vector<std::shared_ptr<lexer_action>> _actions;
+
+		// The actions encoded for execution. Custom and indexed custom actions refer to their entry in
+		// _position_dependent_actions by index. When there are no custom actions this holds only the net effect of the
+		// actions, which is at most a type, a channel and the reduced mode stack operations.
+		std::vector<lexer_action_code> _codes;
+		std::vector<std::shared_ptr<lexer_action>> _position_dependent_actions;
+
+		// The murmur hash of the actions before it is finished, which lets append extend the hash by one action
+		// instead of rehashing the whole sequence.
+		const int32_t _partial_hash_code;
 		const size_t _hash_code;
 
+		// The executors append has created from this one, keyed by the appended action. Executors reachable from a
+		// common root form a trie, so each distinct sequence of actions is copied only the first time it is built.
+		mutable std::mutex _extensions_lock;
+		mutable std::vector<std::pair<std::shared_ptr<lexer_action>, std::shared_ptr<lexer_action_executor>>> _extensions;
+
+	public:
+		// The number of results of fix_offset_before_match remembered by each executor.
+		static const size_t offset_fix_slots = 8;
+
+	private:
+		// The executors fix_offset_before_match has most recently created from this one, in the slot of their offset
+		// and tagged with the id of the lexer_action_cache which interned their wrappers. A new result replaces the one
+		// in its slot, so an executor keeps at most offset_fix_slots of them alive. These are also guarded by
+		// _extensions_lock.
+		struct offset_fix
+		{
+			size_t offset;
+			size_t cache_id;
+			std::shared_ptr<lexer_action_executor> executor;
+		};
+
+		mutable offset_fix _offset_fixes[offset_fix_slots];
+
 		friend bool operator== (lexer_action_executor const&, lexer_action_executor const&);
 		friend std::hash<lexer_action_executor>;
 
 	public:
 		lexer_action_executor(std::vector<std::shared_ptr<lexer_action>>&& actions);
 
+	private:
+		lexer_action_executor(std::vector<std::shared_ptr<lexer_action>>&& actions, int32_t partial_hash_code);
+
 	public:
 		std::vector<std::shared_ptr<lexer_action>> const& actions() const
 		{
 			return _actions;
 		}
 
+		// Executes the actions for a token which started at start_index and has just been accepted. Actions wrapped in an
+		// indexed_custom_action observe the input at their offset from start_index, and the input is restored to its
+		// current position before returning.
+		void execute(lexer_action_target& target, size_t start_index) const;
+
+		// Executes the actions like execute(target, start_index), but dispatches custom actions through the functions of
+		// table rather than lexer_action_target::action.
+		void execute(lexer_action_target& target, size_t start_index, lexer_custom_action_table const& table) const;
+
+	private:
+		template<typename CustomActionDispatcher>
+		void run(lexer_action_target& target, size_t start_index, CustomActionDispatcher const& dispatcher) const;
+
 	public:
 		static std::shared_ptr<lexer_action_executor> append(std::shared_ptr<lexer_action_executor> const& executor, std::shared_ptr<lexer_action> const& action);
+
+		// Returns an executor whose position-dependent actions are wrapped in an indexed_custom_action for offset, or
+		// executor itself if it has none left to wrap. The most recent result for each of offset_fix_slots offsets is
+		// remembered, and the overload taking a lexer_action_cache also interns the wrappers it creates.
 		static std::shared_ptr<lexer_action_executor> fix_offset_before_match(std::shared_ptr<lexer_action_executor> const& executor, size_t offset);
+		static std::shared_ptr<lexer_action_executor> fix_offset_before_match(std::shared_ptr<lexer_action_executor> const& executor, size_t offset, lexer_action_cache& action_cache);
 	};
 
 	bool operator== (lexer_action_executor const& x, lexer_action_executor const& y);
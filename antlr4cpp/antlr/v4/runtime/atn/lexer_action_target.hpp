@@ -0,0 +1,35 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace antlr4 {
+namespace atn {
+
+	// Implemented by lexers to receive the effects of the lexer actions executed when a token is accepted.
+	class lexer_action_target
+	{
+	protected:
+		virtual ~lexer_action_target() { }
+
+	public:
+		virtual void channel(int32_t channel) = 0;
+		virtual void mode(int32_t mode) = 0;
+		virtual void more() = 0;
+		virtual void pop_mode() = 0;
+		virtual void push_mode(int32_t mode) = 0;
+		virtual void skip() = 0;
+		virtual void type(int32_t type) = 0;
+
+		// Executes action action_index of rule rule_index, the user code embedded in the grammar.
+		virtual void action(size_t rule_index, size_t action_index) = 0;
+
+		// The current position of the input stream, and a means of moving it so position-dependent actions observe the
+		// input as it was where they appear in the rule.
+		virtual size_t index() const = 0;
+		virtual void seek(size_t index) = 0;
+	};
+
+}
+}
@@ -0,0 +1,73 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "lexer_action.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	class lexer_action_target;
+
+	// The custom actions of a lexer as a dense table of functions. The tool numbers the actions of a lexer grammar
+	// consecutively across all of its rules, so the action index of a custom_action already serves as the position of
+	// its function in the table. Generated lexers register one table for the grammar, and executors dispatch custom
+	// actions through it with a single indirect call instead of the virtual lexer_action_target::action.
+	class lexer_custom_action_table
+	{
+	public:
+		typedef void (*function)(lexer_action_target& target);
+
+	private:
+		std::vector<function> _functions;
+
+	public:
+		explicit lexer_custom_action_table(std::vector<function>&& functions)
+			: _functions(std::move(functions))
+		{
+		}
+
+	public:
+		size_t size() const
+		{
+			return _functions.size();
+		}
+
+		// Checks, when the ATN is loaded, that every custom action among actions has a function in the table.
+		bool covers(std::vector<std::shared_ptr<lexer_action>> const& actions) const
+		{
+			for each (std::shared_ptr<lexer_action> const& action in actions)
+			{
+				lexer_action const* custom = action.get();
+				if (custom->action_type() == lexer_action::lexer_action_type::indexed_custom)
+				{
+					custom = static_cast<lexer_action::indexed_custom_action const&>(*custom).action().get();
+				}
+
+				if (custom->action_type() == lexer_action::lexer_action_type::custom)
+				{
+					size_t action_index = static_cast<lexer_action::custom_action const*>(custom)->action_index();
+					if (action_index >= _functions.size() || !_functions[action_index])
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		void execute(lexer_action::custom_action const& action, lexer_action_target& target) const
+		{
+			assert(action.action_index() < _functions.size());
+			_functions[action.action_index()](target);
+		}
+	};
+
+}
+}
@@ -0,0 +1,116 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <utility>
+
+#include <antlr/v4/runtime/atn/ll1_analyzer.hpp>
+
+#include <antlr/v4/runtime/token.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/static_closure.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		class look_walker : public static_closure<look_walker, empty_path>
+		{
+		private:
+			misc::interval_set<int32_t>& _result;
+			bool& _predicated;
+
+		public:
+			look_walker(grammar_atn const& atn, misc::interval_set<int32_t>& result, bool& predicated)
+				: static_closure(atn)
+				, _result(result)
+				, _predicated(predicated)
+			{
+			}
+
+		public:
+			bool enter(atn_state const& state, empty_path const& /*path*/)
+			{
+				if (state.state_type() == atn_state::atn_state_type::rule_stop)
+				{
+					_result.insert(token::eof);
+				}
+
+				return true;
+			}
+
+			void follow(transition_table::entry const& transition, empty_path const& path)
+			{
+				switch (transition.type)
+				{
+				case transition::transition_type::predicate:
+				case transition::transition_type::precedence:
+					_predicated = true;
+					closure(transition.target, path);
+					break;
+
+				case transition::transition_type::epsilon:
+				case transition::transition_type::action:
+					closure(transition.target, path);
+					break;
+
+				case transition::transition_type::atom:
+				case transition::transition_type::range:
+					_result.insert(std::make_pair(transition.first, transition.second));
+					break;
+
+				case transition::transition_type::set:
+				case transition::transition_type::not_set:
+					for (int32_t i = transition.first; i < transition.second; i++)
+					{
+						_result.insert(std::make_pair(table().intervals()[i].first, table().intervals()[i].second));
+					}
+
+					break;
+
+				case transition::transition_type::wildcard:
+					_result.insert(std::make_pair(1, atn().max_token_type() + 1));
+					break;
+
+				case transition::transition_type::rule:
+				default:
+					assert(!"Invalid transition type.");
+					break;
+				}
+			}
+		};
+
+	}
+
+	misc::interval_set<int32_t> ll1_analyzer::look(transition_table::entry const& transition, bool& predicated) const
+	{
+		misc::interval_set<int32_t> result;
+		look_walker(_atn, result, predicated).closure(transition, empty_path());
+		return std::move(result);
+	}
+
+	std::vector<misc::interval_set<int32_t>> ll1_analyzer::decision_lookahead(atn_state const& state, bool& predicated) const
+	{
+		assert(_atn.alternative_table());
+		transition_table::view alternatives = _atn.alternative_table()->transitions(static_cast<uint32_t>(state.state_number()));
+		std::vector<misc::interval_set<int32_t>> result;
+		result.reserve(alternatives.size());
+		for each (transition_table::entry const& transition in alternatives)
+		{
+			result.push_back(look(transition, predicated));
+		}
+
+		return std::move(result);
+	}
+
+}
+}
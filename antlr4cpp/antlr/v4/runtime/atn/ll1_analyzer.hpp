@@ -0,0 +1,42 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../misc/interval_set.hpp"
+#include "transition_table.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	class atn_state;
+	class grammar_atn;
+
+	// Computes the set of tokens which can follow a point in a parser ATN, looking through rule invocations, and past the
+	// end of a rule into every place it is invoked from. The analysis is static: the end of a rule reached without a
+	// pending invocation is followed by everything that can follow any invocation of the rule, and by EOF. It reads the
+	// alternative table of the ATN, which must have been built.
+	class ll1_analyzer
+	{
+	private:
+		grammar_atn const& _atn;
+
+	public:
+		explicit ll1_analyzer(grammar_atn const& atn)
+			: _atn(atn)
+		{
+		}
+
+	public:
+		// The tokens which can be matched next after taking transition. Sets predicated if a semantic or precedence
+		// predicate lies on a path to any of them.
+		misc::interval_set<int32_t> look(transition_table::entry const& transition, bool& predicated) const;
+
+		// The lookahead of each alternative of the decision made at state, where alternative n + 1 is entered through
+		// transition n.
+		std::vector<misc::interval_set<int32_t>> decision_lookahead(atn_state const& state, bool& predicated) const;
+	};
+
+}
+}
@@ -0,0 +1,81 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include <antlr/v4/runtime/atn/ll1_decision_table.hpp>
+
+#include <antlr/v4/runtime/token.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/ll1_analyzer.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	const size_t ll1_decision_table::invalid_alternative;
+	const size_t ll1_decision_table::no_table;
+
+	namespace {
+
+		bool disjoint(std::vector<misc::interval_set<int32_t>> const& lookahead)
+		{
+			misc::interval_set<int32_t> seen;
+			for each (misc::interval_set<int32_t> const& alternative in lookahead)
+			{
+				if (!misc::interval_set<int32_t>::combine_and(seen, alternative).empty())
+				{
+					return false;
+				}
+
+				seen.insert(alternative);
+			}
+
+			return true;
+		}
+
+	}
+
+	ll1_decision_table::ll1_decision_table(grammar_atn const& atn)
+		: _row_size(static_cast<size_t>(atn.max_token_type()) + 2)
+		, _ll1_decisions(0)
+	{
+		ll1_analyzer analyzer(atn);
+		_offsets.reserve(atn.decision_states().size());
+		for each (std::shared_ptr<decision_state> const& state in atn.decision_states())
+		{
+			bool predicated = false;
+			std::vector<misc::interval_set<int32_t>> lookahead = analyzer.decision_lookahead(*state, predicated);
+			if (predicated || lookahead.size() > std::numeric_limits<uint16_t>::max() || !disjoint(lookahead))
+			{
+				_offsets.push_back(no_table);
+				continue;
+			}
+
+			size_t offset = _alternatives.size();
+			_offsets.push_back(offset);
+			_alternatives.resize(offset + _row_size, static_cast<uint16_t>(invalid_alternative));
+			for (size_t i = 0; i < lookahead.size(); i++)
+			{
+				for each (misc::interval_set<int32_t>::interval_type const& interval in lookahead[i].pairs())
+				{
+					for (int32_t token = std::max(interval.first, static_cast<int32_t>(token::eof)); token < interval.second && token <= atn.max_token_type(); token++)
+					{
+						_alternatives[offset + static_cast<size_t>(token + 1)] = static_cast<uint16_t>(i + 1);
+					}
+				}
+			}
+
+			_ll1_decisions++;
+		}
+	}
+
+}
+}
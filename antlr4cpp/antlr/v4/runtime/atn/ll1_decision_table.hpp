@@ -0,0 +1,65 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+
+	// Token-to-alternative tables for the decisions of a parser ATN which are LL(1), meaning the lookahead sets of their
+	// alternatives are disjoint and no predicate is involved. Prediction for these decisions is a single table lookup;
+	// the others still need adaptive prediction.
+	class ll1_decision_table
+	{
+		ll1_decision_table(ll1_decision_table const&) = delete;
+		ll1_decision_table& operator= (ll1_decision_table const&) = delete;
+
+	public:
+		static const size_t invalid_alternative = 0;
+
+	private:
+		static const size_t no_table = ~static_cast<size_t>(0);
+
+		// One row of _alternatives per LL(1) decision, indexed by token type + 1 so EOF is in column 0.
+		const size_t _row_size;
+		std::vector<size_t> _offsets;
+		std::vector<uint16_t> _alternatives;
+		size_t _ll1_decisions;
+
+	public:
+		// The transition table of atn must have been built.
+		explicit ll1_decision_table(grammar_atn const& atn);
+
+	public:
+		size_t ll1_decisions() const
+		{
+			return _ll1_decisions;
+		}
+
+		bool ll1(size_t decision) const
+		{
+			return _offsets[decision] != no_table;
+		}
+
+		// The alternative predicted by token at an LL(1) decision, or invalid_alternative if no alternative can start
+		// with it, in which case the caller falls back to adaptive prediction to report the error.
+		size_t predict(size_t decision, int32_t token) const
+		{
+			assert(ll1(decision));
+			size_t column = static_cast<size_t>(token + 1);
+			if (column >= _row_size)
+			{
+				return invalid_alternative;
+			}
+
+			return _alternatives[_offsets[decision] + column];
+		}
+	};
+
+}
+}
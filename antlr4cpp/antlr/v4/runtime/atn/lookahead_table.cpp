@@ -0,0 +1,241 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <set>
+#include <utility>
+
+#include <antlr/v4/runtime/atn/lookahead_table.hpp>
+
+#include <antlr/v4/runtime/token.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/static_closure.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	const size_t lookahead_table::invalid_alternative;
+	const size_t lookahead_table::default_max_rows;
+	const size_t lookahead_table::no_table;
+
+	namespace {
+
+		// A state reached by an alternative together with the follow states of the rule invocations entered to reach
+		// it. The state end_of_input stands for having left the start rule, where only EOF can follow.
+		typedef std::pair<size_t, std::vector<size_t>> configuration;
+		typedef std::set<configuration> configuration_set;
+
+		const size_t end_of_input = atn_state::invalid_state_number;
+
+		class table_compiler : public static_closure<table_compiler, configuration_set*>
+		{
+		private:
+			const size_t _max_k;
+			const size_t _max_rows;
+			const size_t _row_size;
+			std::vector<int32_t>& _cells;
+
+			size_t _first_row;
+
+			bool _predicated;
+
+		public:
+			table_compiler(grammar_atn const& atn, size_t max_k, size_t max_rows, std::vector<int32_t>& cells)
+				: static_closure(atn)
+				, _max_k(max_k)
+				, _max_rows(max_rows)
+				, _row_size(static_cast<size_t>(atn.max_token_type()) + 2)
+				, _cells(cells)
+				, _first_row(cells.size() / _row_size)
+				, _predicated(false)
+			{
+			}
+
+		public:
+			// Compiles the decision made at state, returning its first row and setting depth to the number of tokens it
+			// needs, or returns false and leaves the cells as they were if the decision is not LL(max_k), needs more than
+			// max_rows rows, or involves a predicate.
+			bool compile(atn_state const& state, size_t& root, size_t& depth)
+			{
+				transition_table::view transitions = table().transitions(static_cast<uint32_t>(state.state_number()));
+				std::vector<configuration_set> alternatives(transitions.size());
+				for (size_t i = 0; i < alternatives.size(); i++)
+				{
+					reset();
+					closure(transitions[i], &alternatives[i]);
+				}
+
+				depth = 0;
+				if (_predicated || !compile_row(alternatives, 1, root, depth))
+				{
+					// discard any rows written for the decision
+					_cells.resize(_first_row * _row_size);
+					return false;
+				}
+
+				return true;
+			}
+
+		private:
+			bool compile_row(std::vector<configuration_set> const& alternatives, size_t k, size_t& row, size_t& depth)
+			{
+				row = _cells.size() / _row_size;
+				if (row - _first_row >= _max_rows || row > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+				{
+					// a cell refers to the row as -(row + 1), which must fit an int32_t
+					return false;
+				}
+
+				_cells.resize(_cells.size() + _row_size, static_cast<int32_t>(lookahead_table::invalid_alternative));
+				depth = std::max(depth, k);
+				for (int32_t token = token::eof; token <= atn().max_token_type(); token++)
+				{
+					size_t viable_alternative = 0;
+					size_t viable_alternatives = 0;
+					std::vector<configuration_set> next(alternatives.size());
+					for (size_t i = 0; i < alternatives.size(); i++)
+					{
+						for each (configuration const& config in alternatives[i])
+						{
+							move(config, token, next[i]);
+						}
+
+						if (!next[i].empty())
+						{
+							viable_alternative = i + 1;
+							viable_alternatives++;
+						}
+					}
+
+					if (_predicated)
+					{
+						return false;
+					}
+
+					int32_t cell;
+					if (viable_alternatives <= 1)
+					{
+						cell = static_cast<int32_t>(viable_alternative);
+					}
+					else if (k == _max_k)
+					{
+						return false;
+					}
+					else
+					{
+						size_t child;
+						if (!compile_row(next, k + 1, child, depth))
+						{
+							return false;
+						}
+
+						cell = -static_cast<int32_t>(child) - 1;
+					}
+
+					_cells[row * _row_size + static_cast<size_t>(token + 1)] = cell;
+				}
+
+				return true;
+			}
+
+			void move(configuration const& config, int32_t token, configuration_set& result)
+			{
+				if (config.first == end_of_input)
+				{
+					if (token == token::eof)
+					{
+						result.insert(config);
+					}
+
+					return;
+				}
+
+				for each (transition_table::entry const& transition in table().transitions(static_cast<uint32_t>(config.first)))
+				{
+					if (!transition::epsilon(transition.type) && table().matches(transition, token, 1, atn().max_token_type()))
+					{
+						reset(config.second);
+						closure(transition.target, &result);
+					}
+				}
+			}
+
+		public:
+			// The configurations reached are added to the set the path points to.
+			bool enter(atn_state const& state, configuration_set* const& result)
+			{
+				if (state.state_type() == atn_state::atn_state_type::rule_stop)
+				{
+					result->insert(configuration(end_of_input, std::vector<size_t>()));
+					return true;
+				}
+
+				if (!table().only_epsilon(static_cast<uint32_t>(state.state_number())))
+				{
+					result->insert(configuration(state.state_number(), stack()));
+					return false;
+				}
+
+				return true;
+			}
+
+			void follow(transition_table::entry const& transition, configuration_set* const& result)
+			{
+				switch (transition.type)
+				{
+				case transition::transition_type::predicate:
+				case transition::transition_type::precedence:
+					_predicated = true;
+					break;
+
+				case transition::transition_type::epsilon:
+				case transition::transition_type::action:
+					closure(transition.target, result);
+					break;
+
+				default:
+					assert(!"Invalid epsilon transition type.");
+					break;
+				}
+			}
+		};
+
+	}
+
+	lookahead_table::lookahead_table(grammar_atn const& atn, size_t max_k, size_t max_rows)
+		: _row_size(static_cast<size_t>(atn.max_token_type()) + 2)
+	{
+		assert(max_k > 0);
+		assert(atn.grammar_type() == atn_type::parser);
+
+		_roots.reserve(atn.decision_states().size());
+		_depths.reserve(atn.decision_states().size());
+		for each (std::shared_ptr<decision_state> const& state in atn.decision_states())
+		{
+			size_t root;
+			size_t depth;
+			table_compiler compiler(atn, max_k, max_rows, _cells);
+			if (!compiler.compile(*state, root, depth))
+			{
+				_roots.push_back(no_table);
+				_depths.push_back(0);
+				continue;
+			}
+
+			_roots.push_back(root);
+			_depths.push_back(depth);
+		}
+	}
+
+}
+}
@@ -0,0 +1,91 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+
+	// Nested token-to-alternative tables for the decisions of a parser ATN which are LL(k) for some k no larger than a
+	// configured limit. Each table is a row indexed by token type + 1 whose cells hold either the predicted alternative
+	// or the row to consult for the next token, so prediction for these decisions takes at most k lookups. Decisions
+	// involving predicates, or which need more than the limit of tokens or of rows, are left to adaptive prediction.
+	class lookahead_table
+	{
+		lookahead_table(lookahead_table const&) = delete;
+		lookahead_table& operator= (lookahead_table const&) = delete;
+
+	public:
+		static const size_t invalid_alternative = 0;
+
+		// Each row holds max_token_type + 2 cells, so the rows a decision may take are limited as well as its depth.
+		static const size_t default_max_rows = 64;
+
+	private:
+		static const size_t no_table = ~static_cast<size_t>(0);
+
+		const size_t _row_size;
+
+		// Cells are invalid_alternative, a predicted alternative, or -(row + 1) for the row of the next token.
+		std::vector<int32_t> _cells;
+
+		// The first row and the number of tokens needed for each decision.
+		std::vector<size_t> _roots;
+		std::vector<size_t> _depths;
+
+	public:
+		// The transition table of atn must have been built.
+		lookahead_table(grammar_atn const& atn, size_t max_k, size_t max_rows = default_max_rows);
+
+	public:
+		size_t row_count() const
+		{
+			return _cells.size() / _row_size;
+		}
+
+		bool fixed(size_t decision) const
+		{
+			return _roots[decision] != no_table;
+		}
+
+		// The number of tokens of lookahead prediction may need at a decision compiled into the table.
+		size_t depth(size_t decision) const
+		{
+			assert(fixed(decision));
+			return _depths[decision];
+		}
+
+		// The alternative predicted at a decision compiled into the table, where lookahead(i) returns the type of the
+		// i-th token of lookahead, starting at 1. Returns invalid_alternative if no alternative can start with the input,
+		// in which case the caller falls back to adaptive prediction to report the error.
+		template<typename Lookahead>
+		size_t predict(size_t decision, Lookahead lookahead) const
+		{
+			assert(fixed(decision));
+			size_t row = _roots[decision];
+			for (size_t i = 1; ; i++)
+			{
+				size_t column = static_cast<size_t>(lookahead(i) + 1);
+				if (column >= _row_size)
+				{
+					return invalid_alternative;
+				}
+
+				int32_t cell = _cells[row * _row_size + column];
+				if (cell >= 0)
+				{
+					return static_cast<size_t>(cell);
+				}
+
+				row = static_cast<size_t>(-(cell + 1));
+			}
+		}
+	};
+
+}
+}
@@ -0,0 +1,47 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <antlr/v4/runtime/atn/memoizing_predicate_evaluator.hpp>
+#include <antlr/v4/runtime/misc/murmur_hash.hpp>
+
+namespace antlr4 {
+namespace atn {
+
+	using namespace antlr4::misc;
+
+	size_t memoizing_predicate_evaluator::key_hash::operator() (key const& value) const
+	{
+		int32_t hash = murmur_hash::initialize();
+		hash = murmur_hash::update(hash, value.rule_index);
+		hash = murmur_hash::update(hash, value.predicate_index);
+		hash = murmur_hash::update(hash, static_cast<int32_t>(value.input_index));
+		hash = murmur_hash::update(hash, value.precedence);
+		return static_cast<size_t>(murmur_hash::finish(hash, 4));
+	}
+
+	bool memoizing_predicate_evaluator::sempred(std::shared_ptr<rule_context> const& context, int32_t rule_index, int32_t predicate_index, bool context_dependent)
+	{
+		// a context-dependent predicate may differ between invocations at the same position, even without a context
+		if (context_dependent)
+		{
+			return _evaluator.sempred(context, rule_index, predicate_index, context_dependent);
+		}
+
+		key operands = { rule_index, predicate_index, _input_index, _precedence };
+		auto result = _results.find(operands);
+		if (result == _results.end())
+		{
+			bool value = _evaluator.sempred(context, rule_index, predicate_index, context_dependent);
+			result = _results.insert(std::make_pair(operands, value)).first;
+		}
+
+		return result->second;
+	}
+
+	bool memoizing_predicate_evaluator::precpred(std::shared_ptr<rule_context> const& context, int32_t precedence)
+	{
+		return _evaluator.precpred(context, precedence);
+	}
+
+}
+}
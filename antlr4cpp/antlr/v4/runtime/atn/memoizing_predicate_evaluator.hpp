@@ -0,0 +1,106 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "predicate_evaluator.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	// A predicate_evaluator which remembers the result of each context-independent semantic predicate at each input
+	// position, so the same predicate reached through different alternatives, or again during an SLL to LL retry, is
+	// only evaluated once. Context-dependent predicates and precedence predicates depend on the parser call stack, so
+	// they are always forwarded to the underlying evaluator.
+	//
+	// The memo is opt-in: a recognizer wraps its evaluator in an instance of this class for the duration of one
+	// prediction or one parse, calls position before evaluating predicates at an input index, and discards or clears
+	// the instance afterwards. Results are only valid while the input and any state read by the predicates is
+	// unchanged.
+	class memoizing_predicate_evaluator : public predicate_evaluator
+	{
+		memoizing_predicate_evaluator(memoizing_predicate_evaluator const&) = delete;
+		memoizing_predicate_evaluator& operator= (memoizing_predicate_evaluator const&) = delete;
+
+	public:
+		struct key
+		{
+			int32_t rule_index;
+			int32_t predicate_index;
+			size_t input_index;
+			int32_t precedence;
+		};
+
+	private:
+		struct key_hash
+		{
+			size_t operator() (key const& value) const;
+		};
+
+		struct key_equal_to
+		{
+			bool operator() (key const& x, key const& y) const
+			{
+				return x.rule_index == y.rule_index
+					&& x.predicate_index == y.predicate_index
+					&& x.input_index == y.input_index
+					&& x.precedence == y.precedence;
+			}
+		};
+
+	private:
+		predicate_evaluator& _evaluator;
+		size_t _input_index;
+		int32_t _precedence;
+		std::unordered_map<key, bool, key_hash, key_equal_to> _results;
+
+	public:
+		explicit memoizing_predicate_evaluator(predicate_evaluator& evaluator)
+			: _evaluator(evaluator)
+			, _input_index()
+			, _precedence()
+		{
+		}
+
+		virtual ~memoizing_predicate_evaluator()
+		{
+		}
+
+	public:
+		size_t input_index() const
+		{
+			return _input_index;
+		}
+
+		int32_t precedence() const
+		{
+			return _precedence;
+		}
+
+		size_t size() const
+		{
+			return _results.size();
+		}
+
+		// Sets the input index and the precedence of the current rule invocation used to key subsequent evaluations.
+		void position(size_t input_index, int32_t precedence)
+		{
+			_input_index = input_index;
+			_precedence = precedence;
+		}
+
+		void clear()
+		{
+			_results.clear();
+		}
+
+	public:
+		virtual bool sempred(std::shared_ptr<rule_context> const& context, int32_t rule_index, int32_t predicate_index, bool context_dependent) override;
+		virtual bool precpred(std::shared_ptr<rule_context> const& context, int32_t precedence) override;
+	};
+
+}
+}
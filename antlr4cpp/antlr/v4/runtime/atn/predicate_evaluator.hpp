@@ -0,0 +1,31 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace antlr4 {
+
+	class rule_context;
+
+namespace atn {
+
+	// Implemented by recognizers to evaluate the semantic predicates embedded in a grammar.
+	class predicate_evaluator
+	{
+	protected:
+		virtual ~predicate_evaluator() { }
+
+	public:
+		// Evaluates predicate_index of rule rule_index. The context is null unless the predicate is context dependent, but
+		// a context dependent predicate may also receive a null context when prediction has no outer context, so
+		// context_dependent tells the two cases apart.
+		virtual bool sempred(std::shared_ptr<rule_context> const& context, int32_t rule_index, int32_t predicate_index, bool context_dependent) = 0;
+
+		// Evaluates a precedence predicate, which holds if precedence is at least the precedence of the current
+		// invocation of the left-recursive rule.
+		virtual bool precpred(std::shared_ptr<rule_context> const& context, int32_t precedence) = 0;
+	};
+
+}
+}
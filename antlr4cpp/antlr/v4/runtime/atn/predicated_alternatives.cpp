@@ -0,0 +1,68 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include <antlr/v4/runtime/atn/predicated_alternatives.hpp>
+#include <antlr/v4/runtime/atn/semantic_context.hpp>
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		std::vector<std::shared_ptr<semantic_context>> predicates_of(std::vector<std::pair<std::shared_ptr<semantic_context>, size_t>> const& predictions)
+		{
+			std::vector<std::shared_ptr<semantic_context>> result;
+			result.reserve(predictions.size());
+			for each (auto const& prediction in predictions)
+			{
+				result.push_back(prediction.first);
+			}
+
+			return std::move(result);
+		}
+
+	}
+
+	predicated_alternatives::predicated_alternatives(std::vector<std::pair<std::shared_ptr<semantic_context>, size_t>> const& predictions)
+		: _program(semantic_context_program::compile(predicates_of(predictions)))
+		, _max_alternative()
+	{
+		_alternatives.reserve(predictions.size());
+		for each (auto const& prediction in predictions)
+		{
+			_alternatives.push_back(prediction.second);
+			_max_alternative = std::max(_max_alternative, prediction.second);
+		}
+	}
+
+	std::vector<bool> predicated_alternatives::eval(predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context, bool complete) const
+	{
+		std::vector<bool> result(_alternatives.empty() ? 0 : _max_alternative + 1);
+		std::vector<bool> known(_program.leaf_count());
+		std::vector<bool> values(_program.leaf_count());
+		for (size_t i = 0; i < _alternatives.size(); i++)
+		{
+			size_t alternative = _alternatives[i];
+			if (result[alternative])
+			{
+				// already viable through an earlier prediction
+				continue;
+			}
+
+			if (_program.eval(i, evaluator, context, known, values))
+			{
+				result[alternative] = true;
+				if (!complete)
+				{
+					break;
+				}
+			}
+		}
+
+		return std::move(result);
+	}
+
+}
+}
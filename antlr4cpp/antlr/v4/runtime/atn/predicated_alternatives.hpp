@@ -0,0 +1,53 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "semantic_context_program.hpp"
+
+namespace antlr4 {
+
+	class rule_context;
+
+namespace atn {
+
+	class predicate_evaluator;
+	class semantic_context;
+
+	// The predicated alternatives of a DFA state or configuration set, compiled together so they can be resolved to
+	// the set of viable alternatives in a single pass. Distinct leaf predicates are shared across all of the trees,
+	// and during an evaluation each leaf is evaluated at most once, with its result held in a bitset which the
+	// remaining trees read instead of invoking the predicate again.
+	class predicated_alternatives
+	{
+	private:
+		semantic_context_program _program;
+		std::vector<size_t> _alternatives;
+		size_t _max_alternative;
+
+	public:
+		// Each element pairs a predicate with the alternative it guards. semantic_context::none marks an alternative
+		// which is viable without a predicate.
+		explicit predicated_alternatives(std::vector<std::pair<std::shared_ptr<semantic_context>, size_t>> const& predictions);
+
+	public:
+		size_t size() const
+		{
+			return _alternatives.size();
+		}
+
+		size_t leaf_count() const
+		{
+			return _program.leaf_count();
+		}
+
+		// Returns a vector indexed by alternative where each viable alternative is set. When complete is false the
+		// evaluation stops at the first viable alternative, in the order the predictions were given; otherwise every
+		// alternative is resolved.
+		std::vector<bool> eval(predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context, bool complete) const;
+	};
+
+}
+}
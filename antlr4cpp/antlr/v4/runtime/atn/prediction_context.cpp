@@ -3,11 +3,14 @@
 
 #include <cassert>
 #include <deque>
-#include <unordered_map>
 #include <unordered_set>
 
+#include <antlr/v4/runtime/rule_context.hpp>
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
 #include <antlr/v4/runtime/atn/prediction_context.hpp>
 #include <antlr/v4/runtime/atn/prediction_context_cache.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
 #include <antlr/v4/runtime/misc/murmur_hash.hpp>
 
 #if defined(_MSC_VER) && (_MSC_VER == 1800)
@@ -157,78 +160,6 @@ namespace atn {
 			return hash;
 		}
 
-		// The default hash function for pointers is reference equality. Since C++ does not move objects in memory, we
-		// don't need to provide the specialized hash mechanism here to avoid the computation of an identity hash code
-		// like the Java code needs.
-		typedef std::unordered_map<std::shared_ptr<prediction_context>, std::shared_ptr<prediction_context>> identity_map;
-
-		std::shared_ptr<prediction_context> append_context_impl(std::shared_ptr<prediction_context> const& context, std::shared_ptr<prediction_context> const& suffix, identity_map& visited)
-		{
-			if (suffix->is_empty())
-			{
-				if (suffix->is_empty_local())
-				{
-					if (context->has_empty())
-					{
-						return prediction_context::empty_local;
-					}
-
-					// This is also not implemented in the Java code.
-					throw std::runtime_error("what to do here?");
-				}
-
-				return context;
-			}
-
-			if (suffix->size() != 1)
-			{
-				throw std::runtime_error("Appending a tree suffix is not yet supported.");
-			}
-
-			auto result_it = visited.find(context);
-			if (result_it == visited.end())
-			{
-				std::shared_ptr<prediction_context> result;
-				if (context->is_empty())
-				{
-					result = suffix;
-				}
-				else
-				{
-					size_t parent_count = context->size();
-					if (context->has_empty())
-					{
-						parent_count--;
-					}
-
-					std::vector<std::shared_ptr<prediction_context>> updated_parents(parent_count);
-					std::vector<int32_t> updated_return_states(parent_count);
-					for (size_t i = 0; i < parent_count; i++)
-					{
-						// this loop could be improved with access to the prediction_context::return_states
-						updated_return_states[i] = context->return_state(i);
-					}
-
-					for (size_t i = 0; i < parent_count; i++)
-					{
-						updated_parents[i] = append_context_impl(context->parent(i), suffix, visited);
-					}
-
-					result = std::make_shared<concrete_prediction_context>(std::move(updated_parents), std::move(updated_return_states));
-
-					if (context->has_empty())
-					{
-						prediction_context_cache context_cache(prediction_context_cache::uncached());
-						result = prediction_context::join(result, suffix, context_cache);
-					}
-				}
-
-				result_it = visited.insert(std::make_pair(context, result)).first;
-			}
-
-			return result_it->second;
-		}
-
 	}
 
 	const std::shared_ptr<prediction_context> prediction_context::empty_local(std::make_shared<concrete_prediction_context>());
@@ -294,23 +225,75 @@ namespace atn {
 
 	std::shared_ptr<prediction_context> prediction_context::append_context(std::shared_ptr<prediction_context> const& context, int32_t return_context, prediction_context_cache& context_cache)
 	{
-		return append_context(context, get_child(empty_full, return_context), context_cache);
+		return append_context(context, context_cache.get_child(empty_full, return_context), context_cache);
 	}
 
 	std::shared_ptr<prediction_context> prediction_context::append_context(std::shared_ptr<prediction_context> const& context, std::shared_ptr<prediction_context> const& suffix, prediction_context_cache& context_cache)
+	{
+		return context_cache.append_context(context, suffix);
+	}
+
+	std::shared_ptr<prediction_context> prediction_context::compute_append_context(std::shared_ptr<prediction_context> const& context, std::shared_ptr<prediction_context> const& suffix, prediction_context_cache& context_cache)
 	{
 		if (context->is_empty())
 		{
 			return suffix;
 		}
 
-		if (context->size() == 1)
+		if (suffix->is_empty())
 		{
-			return context_cache.get_child(append_context(context->parents[0], suffix, context_cache), context->return_states[0]);
+			if (suffix->is_empty_local())
+			{
+				if (context->has_empty())
+				{
+					return empty_local;
+				}
+
+				// This is also not implemented in the Java code.
+				throw std::runtime_error("what to do here?");
+			}
+
+			return context;
 		}
 
-		identity_map visited;
-		return append_context_impl(context, suffix, visited);
+		size_t parent_count = context->size();
+		if (context->has_empty())
+		{
+			parent_count--;
+		}
+
+		if (parent_count == 0)
+		{
+			return suffix;
+		}
+
+		// The parents are appended through the cache, so a context reached along several paths, or shared with an
+		// earlier append of the same suffix, is only rewritten once.
+		std::vector<std::shared_ptr<prediction_context>> updated_parents(parent_count);
+		std::vector<int32_t> updated_return_states(context->return_states.begin(), context->return_states.begin() + parent_count);
+		for (size_t i = 0; i < parent_count; i++)
+		{
+			updated_parents[i] = context_cache.append_context(context->parent(i), suffix);
+		}
+
+		std::shared_ptr<prediction_context> result;
+		if (parent_count == 1)
+		{
+			result = context_cache.get_child(updated_parents[0], updated_return_states[0]);
+		}
+		else
+		{
+			result = std::make_shared<concrete_prediction_context>(std::move(updated_parents), std::move(updated_return_states));
+		}
+
+		if (context->has_empty())
+		{
+			// The empty path through the context continues with the entire suffix, which works the same way whether
+			// the suffix is a single path or a tree.
+			result = context_cache.join(result, suffix);
+		}
+
+		return result;
 	}
 
 	std::shared_ptr<prediction_context> prediction_context::get_child(std::shared_ptr<prediction_context> const& context, int32_t return_state)
@@ -318,27 +301,44 @@ namespace atn {
 		return std::make_shared<concrete_prediction_context>(context, return_state);
 	}
 
-	std::shared_ptr<prediction_context> prediction_context::from_rule_context(std::shared_ptr<grammar_atn> const& /*atn*/, std::shared_ptr<rule_context> const& /*outer_context*/, bool /*full_context*/)
+	std::shared_ptr<prediction_context> prediction_context::from_rule_context(std::shared_ptr<grammar_atn> const& atn, std::shared_ptr<rule_context> const& outer_context, bool full_context)
 	{
-		throw std::runtime_error("Not implemented");
-		//if (outer_context->is_empty())
-		//{
-		//	return full_context ? empty_full : empty_local;
-		//}
-
-		//std::shared_ptr<prediction_context> parent;
-		//if (outer_context->parent())
-		//{
-		//	parent = from_rule_context(atn, outer_context->parent(), full_context);
-		//}
-		//else
-		//{
-		//	parent = full_context ? empty_full : empty_local;
-		//}
-
-		//auto state = atn->states().find(outer_context->invoking_state);
-		//auto transition = static_cast<rule_transition>(state->transition(0));
-		//return get_child(parent, transition->follow_state()->state_number());
+		// Walk outward until reaching the root of the parse or a rule context which already knows its prediction
+		// context. Every prediction made while the parser is nested at the same depth shares the contexts computed
+		// here, so this normally stops at outer_context itself.
+		std::vector<std::shared_ptr<rule_context>> pending;
+		std::shared_ptr<prediction_context> result;
+		for (std::shared_ptr<rule_context> current = outer_context; /*empty*/; current = current->parent_context())
+		{
+			if (!current || current->is_empty())
+			{
+				result = full_context ? empty_full : empty_local;
+				break;
+			}
+
+			std::shared_ptr<prediction_context> const& cached = current->cached_prediction_context(full_context);
+			if (cached)
+			{
+				result = cached;
+				break;
+			}
+
+			pending.push_back(current);
+		}
+
+		// Build the missing part of the chain from the outermost context inward, recording each result on the rule
+		// context it was computed for.
+		while (!pending.empty())
+		{
+			std::shared_ptr<rule_context> const& context = pending.back();
+			std::shared_ptr<atn_state> const& state = atn->state(context->invoking_state());
+			rule_transition const& transition = static_cast<rule_transition const&>(*state->transition(0));
+			result = get_child(result, static_cast<int32_t>(transition.follow_state()->state_number()));
+			context->cached_prediction_context(full_context, result);
+			pending.pop_back();
+		}
+
+		return result;
 	}
 
 	std::shared_ptr<prediction_context> prediction_context::join(std::shared_ptr<prediction_context> const& context0, std::shared_ptr<prediction_context> const& context1, prediction_context_cache& context_cache)
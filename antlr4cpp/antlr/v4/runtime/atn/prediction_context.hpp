@@ -83,6 +83,13 @@ namespace atn {
 
 		static std::shared_ptr<prediction_context> from_rule_context(std::shared_ptr<grammar_atn> const& atn, std::shared_ptr<rule_context> const& outer_context, bool full_context = true);
 		static std::shared_ptr<prediction_context> join(std::shared_ptr<prediction_context> const& context0, std::shared_ptr<prediction_context> const& context1, prediction_context_cache& context_cache);
+
+	private:
+		friend class prediction_context_cache;
+
+		// Appends suffix to context, appending to each parent of context through context_cache. The public
+		// append_context goes through the cache, which calls this for (context, suffix) pairs it has not seen.
+		static std::shared_ptr<prediction_context> compute_append_context(std::shared_ptr<prediction_context> const& context, std::shared_ptr<prediction_context> const& suffix, prediction_context_cache& context_cache);
 	};
 
 	bool operator== (prediction_context const& x, prediction_context const& y);
@@ -46,6 +46,41 @@ namespace atn {
 				&& (x.context == y.context || (x.context && y.context && *x.context == *y.context));
 		}
 
+		class prediction_context_pair
+		{
+			prediction_context_pair() = delete;
+			prediction_context_pair(prediction_context_pair const&) = delete;
+			prediction_context_pair& operator= (prediction_context_pair const&) = delete;
+
+		public:
+			const std::shared_ptr<prediction_context> first;
+			const std::shared_ptr<prediction_context> second;
+
+		public:
+			prediction_context_pair(prediction_context_pair&& other)
+				: first(std::move(other.first))
+				, second(std::move(other.second))
+			{
+			}
+
+			prediction_context_pair(std::shared_ptr<prediction_context> const& first, std::shared_ptr<prediction_context> const& second)
+				: first(first)
+				, second(second)
+			{
+			}
+		};
+
+		// Unlike identity_commutative_prediction_context_operands, the order of the operands is significant.
+		bool operator== (prediction_context_pair const& x, prediction_context_pair const& y)
+		{
+			if (&x == &y)
+			{
+				return true;
+			}
+
+			return x.first == y.first && x.second == y.second;
+		}
+
 	}
 
 }
@@ -53,6 +88,19 @@ namespace atn {
 
 namespace std {
 
+	template<>
+	struct hash<antlr4::atn::prediction_context_pair>
+	{
+		size_t operator() (antlr4::atn::prediction_context_pair const& value) const
+		{
+			std::hash<antlr4::atn::prediction_context> hasher;
+			size_t hash = 5;
+			hash = 7 * hash + hasher(*value.first);
+			hash = 7 * hash + hasher(*value.second);
+			return hash;
+		}
+	};
+
 	template<>
 	struct hash<antlr4::atn::prediction_context_and_int>
 	{
@@ -79,6 +127,7 @@ namespace atn {
 		std::unordered_map<std::shared_ptr<prediction_context>, std::shared_ptr<prediction_context>> contexts;
 		std::unordered_map<prediction_context_and_int, std::shared_ptr<prediction_context>> child_contexts;
 		std::unordered_map<identity_commutative_prediction_context_operands, std::shared_ptr<prediction_context>> join_contexts;
+		std::unordered_map<prediction_context_pair, std::shared_ptr<prediction_context>> append_contexts;
 
 	public:
 		data()
@@ -153,5 +202,24 @@ namespace atn {
 		return result->second;
 	}
 
+	std::shared_ptr<prediction_context> prediction_context_cache::append_context(std::shared_ptr<prediction_context> const& context, std::shared_ptr<prediction_context> const& suffix)
+	{
+		if (!private_data)
+		{
+			return prediction_context::compute_append_context(context, suffix, *this);
+		}
+
+		prediction_context_pair operands(context, suffix);
+		auto result = private_data->append_contexts.find(operands);
+		if (result != private_data->append_contexts.end())
+		{
+			return result->second;
+		}
+
+		auto append_context = get_as_cached(prediction_context::compute_append_context(context, suffix, *this));
+		result = private_data->append_contexts.insert(std::make_pair(std::move(operands), std::move(append_context))).first;
+		return result->second;
+	}
+
 }
 }
@@ -30,6 +30,7 @@ namespace atn {
 		std::shared_ptr<prediction_context> get_as_cached(std::shared_ptr<prediction_context> const& context);
 		std::shared_ptr<prediction_context> get_child(std::shared_ptr<prediction_context> const& context, int return_state);
 		std::shared_ptr<prediction_context> join(std::shared_ptr<prediction_context> const& x, std::shared_ptr<prediction_context> const& y);
+		std::shared_ptr<prediction_context> append_context(std::shared_ptr<prediction_context> const& context, std::shared_ptr<prediction_context> const& suffix);
 
 	public:
 		class identity_commutative_prediction_context_operands
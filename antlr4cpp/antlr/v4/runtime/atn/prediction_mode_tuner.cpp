@@ -0,0 +1,178 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <antlr/v4/runtime/atn/prediction_mode_tuner.hpp>
+
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+#include <antlr/v4/runtime/misc/murmur_hash.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		const char* const profile_header = "antlr4-prediction-profile";
+		const int profile_version = 2;
+
+	}
+
+	prediction_mode_tuner::prediction_mode_tuner(grammar_atn const& atn)
+		: _decision_count(atn.decision_states().size())
+		, _grammar_hash(grammar_hash(atn))
+		, _counters(new counters[atn.decision_states().size()])
+	{
+		reset();
+	}
+
+	int32_t prediction_mode_tuner::grammar_hash(grammar_atn const& atn)
+	{
+		// the transition table covers every state, including those a binary_atn has not created yet
+		transition_table const* table = atn.transition_table();
+		assert(table);
+
+		using misc::murmur_hash;
+		size_t words = 0;
+		int32_t hash = murmur_hash::initialize(static_cast<int32_t>(atn.grammar_type()));
+		hash = murmur_hash::update(hash, atn.max_token_type());
+		hash = murmur_hash::update(hash, static_cast<int32_t>(atn.decision_states().size()));
+		hash = murmur_hash::update(hash, static_cast<int32_t>(table->state_count()));
+		words += 3;
+		for (size_t i = 0; i <= table->state_count(); i++)
+		{
+			hash = murmur_hash::update(hash, static_cast<int32_t>(table->offsets()[i]));
+			words++;
+		}
+
+		for (size_t i = 0; i < table->size(); i++)
+		{
+			transition_table::entry const& entry = table->entries()[i];
+			hash = murmur_hash::update(hash, static_cast<int32_t>(entry.type) << 8 | entry.flags);
+			hash = murmur_hash::update(hash, static_cast<int32_t>(entry.target));
+			hash = murmur_hash::update(hash, entry.first);
+			hash = murmur_hash::update(hash, entry.second);
+			words += 4;
+		}
+
+		for (size_t i = 0; i < table->interval_count(); i++)
+		{
+			hash = murmur_hash::update(hash, table->intervals()[i].first);
+			hash = murmur_hash::update(hash, table->intervals()[i].second);
+			words += 2;
+		}
+
+		return murmur_hash::finish(hash, words);
+	}
+
+	prediction_mode_tuner::prediction_mode prediction_mode_tuner::mode(size_t decision, uint64_t min_predictions) const
+	{
+		uint64_t predictions = this->predictions(decision);
+		if (predictions == 0 || predictions < min_predictions)
+		{
+			return prediction_mode::adaptive;
+		}
+
+		uint64_t fallbacks = this->fallbacks(decision);
+		if (fallbacks == 0)
+		{
+			return prediction_mode::sll;
+		}
+
+		if (fallbacks >= predictions)
+		{
+			return prediction_mode::ll;
+		}
+
+		return prediction_mode::adaptive;
+	}
+
+	void prediction_mode_tuner::reset()
+	{
+		for (size_t i = 0; i < _decision_count; i++)
+		{
+			_counters[i].predictions.store(0, std::memory_order_relaxed);
+			_counters[i].fallbacks.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void prediction_mode_tuner::tune(grammar_atn& atn, uint64_t min_predictions) const
+	{
+		for (size_t i = 0; i < _decision_count && i < atn.decision_states().size(); i++)
+		{
+			std::shared_ptr<decision_state> const& state = atn.decision_states()[i];
+			if (!state)
+			{
+				continue;
+			}
+
+			prediction_mode mode = this->mode(i, min_predictions);
+			if (mode != prediction_mode::adaptive)
+			{
+				state->sll(mode == prediction_mode::sll);
+				state->ll(mode == prediction_mode::ll);
+			}
+		}
+	}
+
+	void prediction_mode_tuner::write_profile(std::ostream& output) const
+	{
+		output << profile_header << ' ' << profile_version << ' ' << _grammar_hash << ' ' << _decision_count << '\n';
+		for (size_t i = 0; i < _decision_count; i++)
+		{
+			output << i << ' ' << predictions(i) << ' ' << fallbacks(i) << '\n';
+		}
+	}
+
+	void prediction_mode_tuner::read_profile(std::istream& input)
+	{
+		std::string header;
+		int version;
+		int32_t hash;
+		size_t decision_count;
+		if (!(input >> header >> version >> hash >> decision_count) || header != profile_header || version != profile_version)
+		{
+			throw std::invalid_argument("Not a prediction profile.");
+		}
+
+		if (hash != _grammar_hash || decision_count != _decision_count)
+		{
+			throw std::invalid_argument("The prediction profile was written for a different grammar.");
+		}
+
+		std::vector<std::pair<uint64_t, uint64_t>> counts(decision_count);
+		for (size_t i = 0; i < decision_count; i++)
+		{
+			size_t decision;
+			uint64_t predictions;
+			uint64_t fallbacks;
+			if (!(input >> decision >> predictions >> fallbacks) || decision != i || fallbacks > predictions)
+			{
+				throw std::invalid_argument("Invalid prediction profile entry.");
+			}
+
+			counts[i] = std::make_pair(predictions, fallbacks);
+		}
+
+		for (size_t i = 0; i < decision_count; i++)
+		{
+			_counters[i].predictions.fetch_add(counts[i].first, std::memory_order_relaxed);
+			_counters[i].fallbacks.fetch_add(counts[i].second, std::memory_order_relaxed);
+		}
+	}
+
+}
+}
@@ -0,0 +1,110 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+
+	// Counts, for each decision, the predictions made with SLL and how many of them conflicted and were retried with
+	// full-context LL, and tunes the decision states from the counts: a decision which never falls back is predicted
+	// with SLL only, and a decision which always falls back goes straight to LL. Decisions in between keep the two
+	// stage strategy.
+	//
+	// A recognizer only reports predictions made with the two stage strategy, so a decision keeps its tuned mode until
+	// the counts are reset. The counts can be written as a profile and read back, so settings learned by one process
+	// can be applied by the next. A profile records a hash of the ATN it was counted for, and is only read back by a
+	// tuner for the same ATN.
+	class prediction_mode_tuner
+	{
+		prediction_mode_tuner(prediction_mode_tuner const&) = delete;
+		prediction_mode_tuner& operator= (prediction_mode_tuner const&) = delete;
+
+	public:
+		enum class prediction_mode
+		{
+			adaptive,
+			sll,
+			ll,
+		};
+
+	private:
+		struct counters
+		{
+			std::atomic<uint64_t> predictions;
+			std::atomic<uint64_t> fallbacks;
+		};
+
+	private:
+		const size_t _decision_count;
+		const int32_t _grammar_hash;
+		std::unique_ptr<counters[]> _counters;
+
+	public:
+		// Counts the decisions of atn, which must have its transition table built.
+		explicit prediction_mode_tuner(grammar_atn const& atn);
+
+	public:
+		size_t decision_count() const
+		{
+			return _decision_count;
+		}
+
+		// Identifies the ATN the counts are for by its states and transitions, so a profile is not applied to the
+		// decisions of a different grammar which happens to have the same number of decisions.
+		int32_t grammar_hash() const
+		{
+			return _grammar_hash;
+		}
+
+		static int32_t grammar_hash(grammar_atn const& atn);
+
+		uint64_t predictions(size_t decision) const
+		{
+			return _counters[decision].predictions.load(std::memory_order_relaxed);
+		}
+
+		uint64_t fallbacks(size_t decision) const
+		{
+			return _counters[decision].fallbacks.load(std::memory_order_relaxed);
+		}
+
+		// The mode the counts call for, once decision has made at least min_predictions predictions.
+		prediction_mode mode(size_t decision, uint64_t min_predictions) const;
+
+	public:
+		// Records an SLL prediction for decision, and whether it conflicted and fell back to LL. Safe to call from
+		// multiple threads.
+		void report(size_t decision, bool fell_back)
+		{
+			_counters[decision].predictions.fetch_add(1, std::memory_order_relaxed);
+			if (fell_back)
+			{
+				_counters[decision].fallbacks.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		void reset();
+
+		// Sets the sll and ll flags of each decision state of atn whose decision is tuned to sll or ll. The flags of
+		// adaptive decisions, including those with fewer than min_predictions predictions, are left as they are, so
+		// settings made statically for them are kept.
+		void tune(grammar_atn& atn, uint64_t min_predictions) const;
+
+		// Writes the counts of every decision as a text profile.
+		void write_profile(std::ostream& output) const;
+
+		// Adds the counts of a profile written by write_profile to the counts of this tuner. Throws
+		// std::invalid_argument if the profile is malformed or was written for a different ATN, in which case no counts
+		// are changed.
+		void read_profile(std::istream& input);
+	};
+
+}
+}
@@ -4,10 +4,12 @@
 #include <cassert>
 #include <algorithm>
 #include <iterator>
+#include <mutex>
 #include <stdexcept>
 #include <unordered_set>
 #include <unordered_map>
 
+#include <antlr/v4/runtime/atn/predicate_evaluator.hpp>
 #include <antlr/v4/runtime/atn/semantic_context.hpp>
 #include <antlr/v4/runtime/misc/murmur_hash.hpp>
 #include <antlr/v4/runtime/misc/unordered_ptr_set.hpp>
@@ -46,6 +48,116 @@ namespace atn {
 			return std::move(result);
 		}
 
+		template<typename T>
+		int compare_values(T x, T y)
+		{
+			if (x < y)
+			{
+				return -1;
+			}
+
+			return y < x ? 1 : 0;
+		}
+
+		int compare_contexts(semantic_context const& x, semantic_context const& y);
+
+		int compare_operands(std::vector<semantic_context_ptr> const& x, std::vector<semantic_context_ptr> const& y)
+		{
+			int result = compare_values(x.size(), y.size());
+			for (size_t i = 0; result == 0 && i < x.size(); i++)
+			{
+				result = compare_contexts(*x[i], *y[i]);
+			}
+
+			return result;
+		}
+
+		// Defines the canonical order of operands in semantic_context::and_operator and semantic_context::or_operator.
+		// This is a total order which agrees with operator==, so the operand vectors of equal operators are identical
+		// element by element.
+		int compare_contexts(semantic_context const& x, semantic_context const& y)
+		{
+			if (&x == &y)
+			{
+				return 0;
+			}
+
+			if (x.type() != y.type())
+			{
+				return compare_values(x.type(), y.type());
+			}
+
+			switch (x.type())
+			{
+			case semantic_context::context_type::predicate:
+			{
+				semantic_context::predicate const& left = static_cast<semantic_context::predicate const&>(x);
+				semantic_context::predicate const& right = static_cast<semantic_context::predicate const&>(y);
+				int result = compare_values(left.rule_index(), right.rule_index());
+				if (result == 0)
+				{
+					result = compare_values(left.predicate_index(), right.predicate_index());
+				}
+
+				if (result == 0)
+				{
+					result = compare_values(left.context_dependent(), right.context_dependent());
+				}
+
+				return result;
+			}
+
+			case semantic_context::context_type::precedence_predicate:
+			{
+				semantic_context::precedence_predicate const& left = static_cast<semantic_context::precedence_predicate const&>(x);
+				semantic_context::precedence_predicate const& right = static_cast<semantic_context::precedence_predicate const&>(y);
+				return compare_values(left.precedence(), right.precedence());
+			}
+
+			case semantic_context::context_type::and_operator:
+			{
+				semantic_context::and_operator const& left = static_cast<semantic_context::and_operator const&>(x);
+				semantic_context::and_operator const& right = static_cast<semantic_context::and_operator const&>(y);
+				return compare_operands(left.operands(), right.operands());
+			}
+
+			case semantic_context::context_type::or_operator:
+			{
+				semantic_context::or_operator const& left = static_cast<semantic_context::or_operator const&>(x);
+				semantic_context::or_operator const& right = static_cast<semantic_context::or_operator const&>(y);
+				return compare_operands(left.operands(), right.operands());
+			}
+
+			default:
+				assert(!"Invalid context type.");
+				return 0;
+			}
+		}
+
+		template<typename Container>
+		std::vector<semantic_context_ptr> canonical_operands(Container const& container)
+		{
+			std::vector<semantic_context_ptr> result(container.begin(), container.end());
+			std::sort(result.begin(), result.end(),
+				[](semantic_context_ptr const& x, semantic_context_ptr const& y)
+				{
+					return compare_contexts(*x, *y) < 0;
+				});
+
+			return std::move(result);
+		}
+
+		int32_t calculate_hash_code(semantic_context::context_type type, std::vector<semantic_context_ptr> const& operands)
+		{
+			int32_t hash = murmur_hash::initialize(static_cast<int32_t>(type));
+			for each (semantic_context_ptr const& operand in operands)
+			{
+				hash = murmur_hash::update(hash, operand, ptr_hash<semantic_context_ptr>());
+			}
+
+			return murmur_hash::finish(hash, operands.size());
+		}
+
 	}
 
 	const std::shared_ptr<semantic_context> semantic_context::none = std::make_shared<semantic_context::predicate>(-1, -1, false);
@@ -97,6 +209,68 @@ namespace atn {
 		return std::move(result);
 	}
 
+	std::shared_ptr<semantic_context::precedence_predicate> const& semantic_context::precedence_predicate::instance(int32_t precedence)
+	{
+		static std::mutex instances_lock;
+		static std::unordered_map<int32_t, std::shared_ptr<precedence_predicate>> instances;
+
+		// references to elements of an unordered_map remain valid when the map is rehashed
+		std::lock_guard<std::mutex> guard(instances_lock);
+		std::shared_ptr<precedence_predicate>& result = instances[precedence];
+		if (!result)
+		{
+			result = std::make_shared<precedence_predicate>(precedence);
+		}
+
+		return result;
+	}
+
+	bool semantic_context::eval(predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context) const
+	{
+		switch (type())
+		{
+		case context_type::predicate:
+		{
+			predicate const& self = static_cast<predicate const&>(*this);
+			if (this == none.get())
+			{
+				return true;
+			}
+
+			return evaluator.sempred(self.context_dependent() ? context : nullptr, self.rule_index(), self.predicate_index(), self.context_dependent());
+		}
+
+		case context_type::precedence_predicate:
+			return evaluator.precpred(context, static_cast<precedence_predicate const&>(*this).precedence());
+
+		case context_type::and_operator:
+			for each (semantic_context_ptr const& operand in static_cast<and_operator const&>(*this).operands())
+			{
+				if (!operand->eval(evaluator, context))
+				{
+					return false;
+				}
+			}
+
+			return true;
+
+		case context_type::or_operator:
+			for each (semantic_context_ptr const& operand in static_cast<or_operator const&>(*this).operands())
+			{
+				if (operand->eval(evaluator, context))
+				{
+					return true;
+				}
+			}
+
+			return false;
+
+		default:
+			assert(!"Invalid context type.");
+			return false;
+		}
+	}
+
 	semantic_context::and_operator::and_operator(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y)
 		: semantic_context(context_type::and_operator)
 	{
@@ -135,7 +309,8 @@ namespace atn {
 			operands.insert(*reduced);
 		}
 
-		std::copy(operands.begin(), operands.end(), std::back_inserter(_operands));
+		_operands = canonical_operands(operands);
+		_hash_code = calculate_hash_code(type(), _operands);
 	}
 
 	semantic_context::or_operator::or_operator(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y)
@@ -176,7 +351,8 @@ namespace atn {
 			operands.insert(*reduced);
 		}
 
-		std::copy(operands.begin(), operands.end(), std::back_inserter(_operands));
+		_operands = canonical_operands(operands);
+		_hash_code = calculate_hash_code(type(), _operands);
 	}
 
 	bool operator== (semantic_context const& x, semantic_context const& y)
@@ -211,16 +387,20 @@ namespace atn {
 
 		case semantic_context::context_type::and_operator:
 		{
-			//semantic_context::and_operator const& left = static_cast<semantic_context::and_operator const&>(x);
-			//semantic_context::and_operator const& right = static_cast<semantic_context::and_operator const&>(y);
-			throw std::runtime_error("not implemented");
+			semantic_context::and_operator const& left = static_cast<semantic_context::and_operator const&>(x);
+			semantic_context::and_operator const& right = static_cast<semantic_context::and_operator const&>(y);
+			return std::hash<semantic_context>()(left) == std::hash<semantic_context>()(right)
+				&& left.operands().size() == right.operands().size()
+				&& std::equal(left.operands().begin(), left.operands().end(), right.operands().begin(), ptr_equal_to<semantic_context_ptr>());
 		}
 
 		case semantic_context::context_type::or_operator:
 		{
-			//semantic_context::or_operator const& left = static_cast<semantic_context::or_operator const&>(x);
-			//semantic_context::or_operator const& right = static_cast<semantic_context::or_operator const&>(y);
-			throw std::runtime_error("not implemented");
+			semantic_context::or_operator const& left = static_cast<semantic_context::or_operator const&>(x);
+			semantic_context::or_operator const& right = static_cast<semantic_context::or_operator const&>(y);
+			return std::hash<semantic_context>()(left) == std::hash<semantic_context>()(right)
+				&& left.operands().size() == right.operands().size()
+				&& std::equal(left.operands().begin(), left.operands().end(), right.operands().begin(), ptr_equal_to<semantic_context_ptr>());
 		}
 
 		default:
@@ -261,16 +441,10 @@ namespace std {
 		}
 
 		case semantic_context::context_type::and_operator:
-		{
-			//semantic_context::and_operator const& left = static_cast<semantic_context::and_operator const&>(x);
-			throw std::runtime_error("not implemented");
-		}
+			return static_cast<size_t>(static_cast<semantic_context::and_operator const&>(x)._hash_code);
 
 		case semantic_context::context_type::or_operator:
-		{
-			//semantic_context::or_operator const& left = static_cast<semantic_context::or_operator const&>(x);
-			throw std::runtime_error("not implemented");
-		}
+			return static_cast<size_t>(static_cast<semantic_context::or_operator const&>(x)._hash_code);
 
 		default:
 			assert(!"Invalid context type.");
@@ -1,12 +1,18 @@
 // Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 
 namespace antlr4 {
+
+	class rule_context;
+
 namespace atn {
 
+	class predicate_evaluator;
+
 	class semantic_context
 	{
 	public:
@@ -39,6 +45,9 @@ namespace atn {
 		static std::shared_ptr<semantic_context> combine_and(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y);
 		static std::shared_ptr<semantic_context> combine_or(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y);
 
+	public:
+		bool eval(predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context) const;
+
 	public:
 		class predicate;
 		class precedence_predicate;
@@ -94,14 +103,22 @@ namespace atn {
 		{
 			return _precedence;
 		}
+
+	public:
+		// Gets the shared instance for a precedence level, so precedence transitions and the contexts built from them
+		// do not allocate a new predicate for every use.
+		static std::shared_ptr<precedence_predicate> const& instance(int32_t precedence);
 	};
 
 	class semantic_context::and_operator : public semantic_context
 	{
 	private:
+		friend std::hash<semantic_context>;
 
 	private:
+		// The operands are kept in canonical order so equal trees have identical operand vectors.
 		std::vector<std::shared_ptr<semantic_context>> _operands;
+		int32_t _hash_code;
 
 	public:
 		and_operator(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y);
@@ -116,9 +133,12 @@ namespace atn {
 	class semantic_context::or_operator : public semantic_context
 	{
 	private:
+		friend std::hash<semantic_context>;
 
 	private:
+		// The operands are kept in canonical order so equal trees have identical operand vectors.
 		std::vector<std::shared_ptr<semantic_context>> _operands;
+		int32_t _hash_code;
 
 	public:
 		or_operator(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y);
@@ -0,0 +1,166 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <functional>
+#include <unordered_map>
+
+#include <antlr/v4/runtime/atn/semantic_context.hpp>
+#include <antlr/v4/runtime/atn/semantic_context_cache.hpp>
+#include <antlr/v4/runtime/misc/unordered_ptr_set.hpp>
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		// Operands of a memoized combine_and or combine_or. Both operands are interned before lookup, so identity
+		// comparison is sufficient, and since the operators are commutative the order is not significant.
+		class identity_commutative_semantic_context_operands
+		{
+			identity_commutative_semantic_context_operands() = delete;
+
+		public:
+			const std::shared_ptr<semantic_context> x;
+			const std::shared_ptr<semantic_context> y;
+
+		public:
+			identity_commutative_semantic_context_operands(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y)
+				: x(x)
+				, y(y)
+			{
+			}
+		};
+
+		bool operator== (identity_commutative_semantic_context_operands const& x, identity_commutative_semantic_context_operands const& y)
+		{
+			return (x.x == y.x && x.y == y.y)
+				|| (x.x == y.y && x.y == y.x);
+		}
+
+	}
+
+}
+}
+
+namespace std {
+
+	template<>
+	struct hash<antlr4::atn::identity_commutative_semantic_context_operands>
+	{
+		size_t operator() (antlr4::atn::identity_commutative_semantic_context_operands const& value) const
+		{
+			// order the operands by address before combining them, so (x, y) and (y, x) agree without a plain xor, which
+			// sends every (x, x) to 0
+			std::less<antlr4::atn::semantic_context*> less;
+			antlr4::atn::semantic_context* first = less(value.y.get(), value.x.get()) ? value.y.get() : value.x.get();
+			antlr4::atn::semantic_context* second = first == value.x.get() ? value.y.get() : value.x.get();
+
+			std::hash<antlr4::atn::semantic_context*> hasher;
+			size_t hash = 5;
+			hash = 31 * hash + hasher(first);
+			hash = 31 * hash + hasher(second);
+			return hash;
+		}
+	};
+
+}
+
+namespace antlr4 {
+namespace atn {
+
+	class semantic_context_cache::data
+	{
+		data(data const&) = delete;
+		data& operator= (data const&) = delete;
+
+	public:
+		misc::unordered_ptr_set<std::shared_ptr<semantic_context>> contexts;
+		std::unordered_map<identity_commutative_semantic_context_operands, std::shared_ptr<semantic_context>> and_contexts;
+		std::unordered_map<identity_commutative_semantic_context_operands, std::shared_ptr<semantic_context>> or_contexts;
+
+	public:
+		data()
+		{
+			// semantic_context::none is compared by identity throughout the runtime, so it must be the instance any
+			// equal predicate interns to
+			contexts.insert(semantic_context::none);
+		}
+	};
+
+	semantic_context_cache::semantic_context_cache(bool enable_cache)
+		: private_data(enable_cache ? std::move(std::make_unique<semantic_context_cache::data>()) : nullptr)
+	{
+	}
+
+	semantic_context_cache::semantic_context_cache(semantic_context_cache && cache)
+		: private_data(std::move(cache.private_data))
+	{
+	}
+
+	semantic_context_cache::~semantic_context_cache()
+	{
+	}
+
+	semantic_context_cache semantic_context_cache::uncached()
+	{
+		return semantic_context_cache(false);
+	}
+
+	size_t semantic_context_cache::size() const
+	{
+		return private_data ? private_data->contexts.size() : 0;
+	}
+
+	std::shared_ptr<semantic_context> semantic_context_cache::get_as_cached(std::shared_ptr<semantic_context> const& context)
+	{
+		if (!private_data || !context)
+		{
+			return context;
+		}
+
+		return *private_data->contexts.insert(context).first;
+	}
+
+	std::shared_ptr<semantic_context> semantic_context_cache::precedence_predicate(int32_t precedence)
+	{
+		return get_as_cached(semantic_context::precedence_predicate::instance(precedence));
+	}
+
+	std::shared_ptr<semantic_context> semantic_context_cache::combine_and(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y)
+	{
+		if (!private_data)
+		{
+			return semantic_context::combine_and(x, y);
+		}
+
+		identity_commutative_semantic_context_operands operands(get_as_cached(x), get_as_cached(y));
+		auto result = private_data->and_contexts.find(operands);
+		if (result == private_data->and_contexts.end())
+		{
+			auto and_context = get_as_cached(semantic_context::combine_and(operands.x, operands.y));
+			result = private_data->and_contexts.insert(std::make_pair(std::move(operands), std::move(and_context))).first;
+		}
+
+		return result->second;
+	}
+
+	std::shared_ptr<semantic_context> semantic_context_cache::combine_or(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y)
+	{
+		if (!private_data)
+		{
+			return semantic_context::combine_or(x, y);
+		}
+
+		identity_commutative_semantic_context_operands operands(get_as_cached(x), get_as_cached(y));
+		auto result = private_data->or_contexts.find(operands);
+		if (result == private_data->or_contexts.end())
+		{
+			auto or_context = get_as_cached(semantic_context::combine_or(operands.x, operands.y));
+			result = private_data->or_contexts.insert(std::make_pair(std::move(operands), std::move(or_context))).first;
+		}
+
+		return result->second;
+	}
+
+}
+}
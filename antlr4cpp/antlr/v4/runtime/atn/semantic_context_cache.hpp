@@ -0,0 +1,43 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace antlr4 {
+namespace atn {
+
+	class semantic_context;
+
+	// Interns semantic contexts so that structurally equal predicate trees share a single instance. Configurations
+	// and DFA states holding interned contexts can then be deduplicated with a pointer comparison. The results of
+	// combine_and and combine_or are memoized, so combining the same pair of contexts again does not allocate.
+	class semantic_context_cache
+	{
+		class data;
+
+		semantic_context_cache(semantic_context_cache const&) = delete;
+		semantic_context_cache& operator= (semantic_context_cache const&) = delete;
+
+	private:
+		std::unique_ptr<data> private_data;
+
+	public:
+		semantic_context_cache(bool enable_cache = true);
+		semantic_context_cache(semantic_context_cache&& cache);
+		~semantic_context_cache();
+
+	public:
+		static semantic_context_cache uncached();
+
+	public:
+		size_t size() const;
+
+		std::shared_ptr<semantic_context> get_as_cached(std::shared_ptr<semantic_context> const& context);
+		std::shared_ptr<semantic_context> precedence_predicate(int32_t precedence);
+		std::shared_ptr<semantic_context> combine_and(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y);
+		std::shared_ptr<semantic_context> combine_or(std::shared_ptr<semantic_context> const& x, std::shared_ptr<semantic_context> const& y);
+	};
+
+}
+}
@@ -0,0 +1,327 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <antlr/v4/runtime/atn/predicate_evaluator.hpp>
+#include <antlr/v4/runtime/atn/semantic_context.hpp>
+#include <antlr/v4/runtime/atn/semantic_context_program.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		typedef semantic_context_program::opcode opcode;
+		typedef semantic_context_program::instruction instruction;
+		typedef semantic_context_program::predicate_reference predicate_reference;
+
+		class compiler
+		{
+		public:
+			std::vector<instruction> code;
+			std::vector<size_t> entries;
+			std::vector<predicate_reference> predicates;
+			std::vector<int32_t> precedences;
+
+		public:
+			void emit(semantic_context const& context)
+			{
+				switch (context.type())
+				{
+				case semantic_context::context_type::predicate:
+				{
+					if (&context == semantic_context::none.get())
+					{
+						code.push_back(instruction { opcode::constant_true, 0 });
+						break;
+					}
+
+					semantic_context::predicate const& predicate = static_cast<semantic_context::predicate const&>(context);
+					code.push_back(instruction { opcode::predicate, predicate_id(predicate) });
+					break;
+				}
+
+				case semantic_context::context_type::precedence_predicate:
+					code.push_back(instruction { opcode::precedence, precedence_id(static_cast<semantic_context::precedence_predicate const&>(context).precedence()) });
+					break;
+
+				case semantic_context::context_type::and_operator:
+					emit_operator(static_cast<semantic_context::and_operator const&>(context).operands(), opcode::jump_if_false);
+					break;
+
+				case semantic_context::context_type::or_operator:
+					emit_operator(static_cast<semantic_context::or_operator const&>(context).operands(), opcode::jump_if_true);
+					break;
+
+				default:
+					assert(!"Invalid context type.");
+					break;
+				}
+			}
+
+			// After code has been emitted, a jump which lands on a jump of the same kind will always be taken again,
+			// and a jump which lands on a jump of the opposite kind will never be taken. Either way the first jump
+			// can go directly to the final destination, so nested operators exit in a single step.
+			void thread_jumps()
+			{
+				for (size_t i = code.size(); i-- > 0; /*empty*/)
+				{
+					instruction& current = code[i];
+					if (current.op != opcode::jump_if_false && current.op != opcode::jump_if_true)
+					{
+						continue;
+					}
+
+					// targets always follow the jump, so this terminates
+					size_t target = static_cast<size_t>(current.operand);
+					while (target < code.size())
+					{
+						instruction const& next = code[target];
+						if (next.op == current.op)
+						{
+							target = static_cast<size_t>(next.operand);
+						}
+						else if (next.op == opcode::jump_if_false || next.op == opcode::jump_if_true)
+						{
+							target++;
+						}
+						else
+						{
+							break;
+						}
+					}
+
+					current.operand = static_cast<int32_t>(target);
+				}
+			}
+
+		private:
+			int32_t predicate_id(semantic_context::predicate const& predicate)
+			{
+				for (size_t i = 0; i < predicates.size(); i++)
+				{
+					predicate_reference const& existing = predicates[i];
+					if (existing.rule_index == predicate.rule_index()
+						&& existing.predicate_index == predicate.predicate_index()
+						&& existing.context_dependent == predicate.context_dependent())
+					{
+						return static_cast<int32_t>(i);
+					}
+				}
+
+				predicates.push_back(predicate_reference { predicate.rule_index(), predicate.predicate_index(), predicate.context_dependent() });
+				return static_cast<int32_t>(predicates.size() - 1);
+			}
+
+			int32_t precedence_id(int32_t precedence)
+			{
+				auto existing = std::find(precedences.begin(), precedences.end(), precedence);
+				if (existing != precedences.end())
+				{
+					return static_cast<int32_t>(existing - precedences.begin());
+				}
+
+				precedences.push_back(precedence);
+				return static_cast<int32_t>(precedences.size() - 1);
+			}
+
+			void emit_operator(std::vector<std::shared_ptr<semantic_context>> const& operands, opcode short_circuit)
+			{
+				std::vector<size_t> exits;
+				for (size_t i = 0; i < operands.size(); i++)
+				{
+					emit(*operands[i]);
+					if (i + 1 < operands.size())
+					{
+						exits.push_back(code.size());
+						code.push_back(instruction { short_circuit, 0 });
+					}
+				}
+
+				for each (size_t exit in exits)
+				{
+					code[exit].operand = static_cast<int32_t>(code.size());
+				}
+			}
+		};
+
+		class direct_leaf_evaluator
+		{
+		private:
+			semantic_context_program const& _program;
+			predicate_evaluator& _evaluator;
+			std::shared_ptr<rule_context> const& _context;
+
+		public:
+			direct_leaf_evaluator(semantic_context_program const& program, predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context)
+				: _program(program)
+				, _evaluator(evaluator)
+				, _context(context)
+			{
+			}
+
+			bool predicate(int32_t operand)
+			{
+				predicate_reference const& predicate = _program.predicates()[static_cast<size_t>(operand)];
+				return _evaluator.sempred(predicate.context_dependent ? _context : nullptr, predicate.rule_index, predicate.predicate_index, predicate.context_dependent);
+			}
+
+			bool precedence(int32_t operand)
+			{
+				return _evaluator.precpred(_context, _program.precedences()[static_cast<size_t>(operand)]);
+			}
+		};
+
+		class memoized_leaf_evaluator
+		{
+		private:
+			direct_leaf_evaluator _evaluator;
+			const size_t _precedence_offset;
+			std::vector<bool>& _known;
+			std::vector<bool>& _values;
+
+		public:
+			memoized_leaf_evaluator(semantic_context_program const& program, predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context, std::vector<bool>& known, std::vector<bool>& values)
+				: _evaluator(program, evaluator, context)
+				, _precedence_offset(program.predicates().size())
+				, _known(known)
+				, _values(values)
+			{
+				_known.resize(program.leaf_count());
+				_values.resize(program.leaf_count());
+			}
+
+			bool predicate(int32_t operand)
+			{
+				size_t leaf = static_cast<size_t>(operand);
+				if (!_known[leaf])
+				{
+					_values[leaf] = _evaluator.predicate(operand);
+					_known[leaf] = true;
+				}
+
+				return _values[leaf];
+			}
+
+			bool precedence(int32_t operand)
+			{
+				size_t leaf = _precedence_offset + static_cast<size_t>(operand);
+				if (!_known[leaf])
+				{
+					_values[leaf] = _evaluator.precedence(operand);
+					_known[leaf] = true;
+				}
+
+				return _values[leaf];
+			}
+		};
+
+	}
+
+	semantic_context_program semantic_context_program::compile(std::shared_ptr<semantic_context> const& context)
+	{
+		return compile(std::vector<std::shared_ptr<semantic_context>> { context });
+	}
+
+	semantic_context_program semantic_context_program::compile(std::vector<std::shared_ptr<semantic_context>> const& contexts)
+	{
+		compiler compiler;
+		for each (std::shared_ptr<semantic_context> const& context in contexts)
+		{
+			compiler.entries.push_back(compiler.code.size());
+			if (context)
+			{
+				compiler.emit(*context);
+			}
+
+			compiler.code.push_back(instruction { opcode::halt, 0 });
+		}
+
+		compiler.thread_jumps();
+
+		semantic_context_program result;
+		result._code = std::move(compiler.code);
+		result._entries = std::move(compiler.entries);
+		result._predicates = std::move(compiler.predicates);
+		result._precedences = std::move(compiler.precedences);
+		return result;
+	}
+
+	bool semantic_context_program::eval(predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context) const
+	{
+		return eval(0, evaluator, context);
+	}
+
+	bool semantic_context_program::eval(size_t entry, predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context) const
+	{
+		direct_leaf_evaluator leaf_evaluator(*this, evaluator, context);
+		return run(_entries[entry], leaf_evaluator);
+	}
+
+	bool semantic_context_program::eval(size_t entry, predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context, std::vector<bool>& known, std::vector<bool>& values) const
+	{
+		memoized_leaf_evaluator leaf_evaluator(*this, evaluator, context, known, values);
+		return run(_entries[entry], leaf_evaluator);
+	}
+
+	template<typename LeafEvaluator>
+	bool semantic_context_program::run(size_t pc, LeafEvaluator& leaf_evaluator) const
+	{
+		const instruction* const code = _code.data();
+		const size_t size = _code.size();
+
+		bool result = true;
+		while (pc < size)
+		{
+			instruction const& current = code[pc++];
+			switch (current.op)
+			{
+			case opcode::constant_true:
+				result = true;
+				break;
+
+			case opcode::predicate:
+				result = leaf_evaluator.predicate(current.operand);
+				break;
+
+			case opcode::precedence:
+				result = leaf_evaluator.precedence(current.operand);
+				break;
+
+			case opcode::halt:
+				return result;
+
+			case opcode::jump_if_false:
+				if (!result)
+				{
+					pc = static_cast<size_t>(current.operand);
+				}
+
+				break;
+
+			case opcode::jump_if_true:
+				if (result)
+				{
+					pc = static_cast<size_t>(current.operand);
+				}
+
+				break;
+
+			default:
+				assert(!"Invalid opcode.");
+				return false;
+			}
+		}
+
+		return result;
+	}
+
+}
+}
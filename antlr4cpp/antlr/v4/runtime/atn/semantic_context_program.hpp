@@ -0,0 +1,120 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace antlr4 {
+
+	class rule_context;
+
+namespace atn {
+
+	class predicate_evaluator;
+	class semantic_context;
+
+	// A semantic_context tree flattened into a linear program. Evaluating the program produces the same result, with
+	// the same short-circuit behavior and order of predicate invocations, as semantic_context::eval, but without
+	// walking the tree of operator nodes.
+	//
+	// The program operates on a single boolean result register. Each predicate instruction overwrites the register,
+	// and the conditional jumps implement the short-circuit evaluation of the and/or operators. After the last
+	// instruction the register holds the value of the whole tree.
+	//
+	// Several trees may be compiled into one program, in which case each tree starts at one of entries() and ends
+	// with a halt instruction. The trees share the predicate tables, so each distinct predicate has a single leaf id
+	// across the whole program.
+	class semantic_context_program
+	{
+	public:
+		enum class opcode : int32_t
+		{
+			// result = true
+			constant_true,
+
+			// result = sempred(predicates()[operand])
+			predicate,
+
+			// result = precpred(precedences()[operand])
+			precedence,
+
+			// if (!result) jump to instruction operand
+			jump_if_false,
+
+			// if (result) jump to instruction operand
+			jump_if_true,
+
+			// stop evaluating the current tree
+			halt,
+		};
+
+		struct instruction
+		{
+			opcode op;
+			int32_t operand;
+		};
+
+		struct predicate_reference
+		{
+			int32_t rule_index;
+			int32_t predicate_index;
+			bool context_dependent;
+		};
+
+	private:
+		std::vector<instruction> _code;
+		std::vector<size_t> _entries;
+		std::vector<predicate_reference> _predicates;
+		std::vector<int32_t> _precedences;
+
+	public:
+		semantic_context_program()
+		{
+		}
+
+	public:
+		static semantic_context_program compile(std::shared_ptr<semantic_context> const& context);
+		static semantic_context_program compile(std::vector<std::shared_ptr<semantic_context>> const& contexts);
+
+	public:
+		std::vector<instruction> const& code() const
+		{
+			return _code;
+		}
+
+		std::vector<size_t> const& entries() const
+		{
+			return _entries;
+		}
+
+		std::vector<predicate_reference> const& predicates() const
+		{
+			return _predicates;
+		}
+
+		std::vector<int32_t> const& precedences() const
+		{
+			return _precedences;
+		}
+
+		// Leaf ids number the predicates first, followed by the precedence predicates.
+		size_t leaf_count() const
+		{
+			return _predicates.size() + _precedences.size();
+		}
+
+		bool eval(predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context) const;
+		bool eval(size_t entry, predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context) const;
+
+		// Evaluates the tree at the given entry, taking the value of each leaf from values if it is set in known, and
+		// otherwise evaluating the leaf and recording its value in both.
+		bool eval(size_t entry, predicate_evaluator& evaluator, std::shared_ptr<rule_context> const& context, std::vector<bool>& known, std::vector<bool>& values) const;
+
+	private:
+		template<typename LeafEvaluator>
+		bool run(size_t pc, LeafEvaluator& leaf_evaluator) const;
+	};
+
+}
+}
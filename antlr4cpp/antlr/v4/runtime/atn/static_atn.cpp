@@ -0,0 +1,276 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <utility>
+
+#include <antlr/v4/runtime/atn/static_atn.hpp>
+
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/lexer_action.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	const uint32_t static_atn::no_state;
+	const uint32_t static_atn::precedence_rule;
+	const uint32_t static_atn::precedence_rule_decision;
+	const uint32_t static_atn::non_greedy;
+
+	namespace {
+
+		uint32_t state_number(std::shared_ptr<atn_state> const& state)
+		{
+			return state ? static_cast<uint32_t>(state->state_number()) : static_atn::no_state;
+		}
+
+		std::shared_ptr<atn_state> make_state(static_atn::state const& record, size_t state_number)
+		{
+			switch (record.type)
+			{
+			case atn_state::atn_state_type::invalid:
+				return nullptr;
+
+			case atn_state::atn_state_type::basic:
+				return std::make_shared<basic_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::rule_start:
+			{
+				std::shared_ptr<rule_start_state> result = std::make_shared<rule_start_state>(state_number, record.rule_index);
+				result->precedence_rule((record.flags & static_atn::precedence_rule) != 0);
+				return result;
+			}
+
+			case atn_state::atn_state_type::block_start:
+				return std::make_shared<basic_block_start_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::plus_block_start:
+				return std::make_shared<plus_block_start_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::star_block_start:
+				return std::make_shared<star_block_start_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::token_start:
+				return std::make_shared<tokens_start_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::rule_stop:
+				return std::make_shared<rule_stop_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::block_end:
+				return std::make_shared<block_end_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::star_loop_back:
+				return std::make_shared<star_loopback_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::star_loop_entry:
+			{
+				std::shared_ptr<star_loop_entry_state> result = std::make_shared<star_loop_entry_state>(state_number, record.rule_index);
+				result->precedence_rule_decision((record.flags & static_atn::precedence_rule_decision) != 0);
+				return result;
+			}
+
+			case atn_state::atn_state_type::plus_loop_back:
+				return std::make_shared<plus_loopback_state>(state_number, record.rule_index);
+
+			case atn_state::atn_state_type::loop_end:
+				return std::make_shared<loop_end_state>(state_number, record.rule_index);
+
+			default:
+				assert(!"Invalid ATN state type.");
+				return nullptr;
+			}
+		}
+
+	}
+
+	std::unique_ptr<grammar_atn> static_atn::instantiate() const
+	{
+		std::unique_ptr<grammar_atn> result(new grammar_atn(grammar_type, max_token_type));
+		for (size_t i = 0; i < state_count; i++)
+		{
+			result->add_state(create_state(states[i], i));
+		}
+
+		for (size_t i = 0; i < state_count; i++)
+		{
+			if (result->state(i))
+			{
+				link_state(*result, states[i], *result->state(i));
+			}
+		}
+
+		for (size_t i = 0; i < rule_count; i++)
+		{
+			result->add_rule_start_state(std::static_pointer_cast<rule_start_state>(result->state(rule_start_states[i])));
+		}
+
+		for (size_t i = 0; i < decision_count; i++)
+		{
+			result->add_decision_state(std::static_pointer_cast<decision_state>(result->state(decision_states[i])));
+		}
+
+		std::unique_ptr<transition_table> alternative_table;
+		if (alternative_transition_offsets)
+		{
+			alternative_table.reset(new transition_table(state_count, alternative_transition_offsets, alternative_transitions, alternative_interval_count, alternative_intervals));
+		}
+
+		result->attach_transition_table(std::unique_ptr<transition_table>(new transition_table(state_count, transition_offsets, transitions, interval_count, intervals)), std::move(alternative_table));
+		return result;
+	}
+
+	static_atn::state static_atn::describe(atn_state const& state)
+	{
+		static_atn::state result = { state.state_type(), static_cast<uint32_t>(state.rule_index()), no_state, no_state, 0 };
+		switch (state.state_type())
+		{
+		case atn_state::atn_state_type::block_start:
+		case atn_state::atn_state_type::star_block_start:
+			result.end_state = state_number(static_cast<block_start_state const&>(state).end_state());
+			break;
+
+		case atn_state::atn_state_type::plus_block_start:
+			result.end_state = state_number(static_cast<plus_block_start_state const&>(state).end_state());
+			result.loopback_state = state_number(static_cast<plus_block_start_state const&>(state).loopback_state());
+			break;
+
+		case atn_state::atn_state_type::block_end:
+			result.end_state = state_number(static_cast<block_end_state const&>(state).start_state());
+			break;
+
+		case atn_state::atn_state_type::star_loop_entry:
+			result.loopback_state = state_number(static_cast<star_loop_entry_state const&>(state).loopback_state());
+			if (static_cast<star_loop_entry_state const&>(state).precedence_rule_decision())
+			{
+				result.flags |= precedence_rule_decision;
+			}
+
+			break;
+
+		case atn_state::atn_state_type::loop_end:
+			result.loopback_state = state_number(static_cast<loop_end_state const&>(state).loopback_state());
+			break;
+
+		case atn_state::atn_state_type::rule_start:
+			result.end_state = state_number(static_cast<rule_start_state const&>(state).stop_state());
+			if (static_cast<rule_start_state const&>(state).precedence_rule())
+			{
+				result.flags |= precedence_rule;
+			}
+
+			break;
+
+		default:
+			break;
+		}
+
+		if (decision(state.state_type()) && !static_cast<decision_state const&>(state).greedy())
+		{
+			result.flags |= non_greedy;
+		}
+
+		return result;
+	}
+
+	bool static_atn::decision(atn_state::atn_state_type type)
+	{
+		switch (type)
+		{
+		case atn_state::atn_state_type::block_start:
+		case atn_state::atn_state_type::plus_block_start:
+		case atn_state::atn_state_type::star_block_start:
+		case atn_state::atn_state_type::token_start:
+		case atn_state::atn_state_type::plus_loop_back:
+		case atn_state::atn_state_type::star_loop_entry:
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	lexer_action_code static_atn::encode(lexer_action const& action)
+	{
+		switch (action.action_type())
+		{
+		case lexer_action::lexer_action_type::channel:
+			return lexer_action_code { action.action_type(), static_cast<lexer_action::channel_action const&>(action).channel() };
+
+		case lexer_action::lexer_action_type::mode:
+			return lexer_action_code { action.action_type(), static_cast<lexer_action::mode_action const&>(action).mode() };
+
+		case lexer_action::lexer_action_type::push_mode:
+			return lexer_action_code { action.action_type(), static_cast<lexer_action::push_mode_action const&>(action).mode() };
+
+		case lexer_action::lexer_action_type::type:
+			return lexer_action_code { action.action_type(), static_cast<lexer_action::type_action const&>(action).type() };
+
+		case lexer_action::lexer_action_type::custom:
+			return lexer_action_code { action.action_type(), static_cast<int32_t>(static_cast<lexer_action::custom_action const&>(action).action_index()) };
+
+		case lexer_action::lexer_action_type::more:
+		case lexer_action::lexer_action_type::pop_mode:
+		case lexer_action::lexer_action_type::skip:
+			return lexer_action_code { action.action_type(), 0 };
+
+		default:
+			assert(!"Invalid lexer action type.");
+			return lexer_action_code { action.action_type(), 0 };
+		}
+	}
+
+	std::shared_ptr<atn_state> static_atn::create_state(state const& record, size_t state_number)
+	{
+		std::shared_ptr<atn_state> result = make_state(record, state_number);
+		if (result && decision(record.type))
+		{
+			static_cast<decision_state&>(*result).greedy((record.flags & non_greedy) == 0);
+		}
+
+		return result;
+	}
+
+	void static_atn::link_state(grammar_atn const& atn, state const& record, atn_state& state)
+	{
+		std::shared_ptr<atn_state> end_state = record.end_state != no_state ? atn.state(record.end_state) : nullptr;
+		std::shared_ptr<atn_state> loopback_state = record.loopback_state != no_state ? atn.state(record.loopback_state) : nullptr;
+		switch (record.type)
+		{
+		case atn_state::atn_state_type::block_start:
+		case atn_state::atn_state_type::star_block_start:
+			static_cast<block_start_state&>(state).end_state(std::static_pointer_cast<block_end_state>(end_state));
+			break;
+
+		case atn_state::atn_state_type::plus_block_start:
+			static_cast<plus_block_start_state&>(state).end_state(std::static_pointer_cast<block_end_state>(end_state));
+			static_cast<plus_block_start_state&>(state).loopback_state(std::static_pointer_cast<plus_loopback_state>(loopback_state));
+			break;
+
+		case atn_state::atn_state_type::block_end:
+			static_cast<block_end_state&>(state).start_state(std::static_pointer_cast<block_start_state>(end_state));
+			break;
+
+		case atn_state::atn_state_type::star_loop_entry:
+			static_cast<star_loop_entry_state&>(state).loopback_state(std::static_pointer_cast<star_loopback_state>(loopback_state));
+			break;
+
+		case atn_state::atn_state_type::loop_end:
+			static_cast<loop_end_state&>(state).loopback_state(loopback_state);
+			break;
+
+		case atn_state::atn_state_type::rule_start:
+			static_cast<rule_start_state&>(state).stop_state(std::static_pointer_cast<rule_stop_state>(end_state));
+			break;
+
+		default:
+			break;
+		}
+	}
+
+}
+}
@@ -0,0 +1,96 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "atn_state.hpp"
+#include "atn_type.hpp"
+#include "lexer_action_code.hpp"
+#include "transition_table.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+
+	// The ATN of a grammar as read-only arrays, as emitted into generated code by static_atn_writer. The arrays are
+	// initialized as constants, so they are placed in the read-only data of the program and cost nothing to load.
+	struct static_atn
+	{
+		static const uint32_t no_state = ~static_cast<uint32_t>(0);
+
+		static const uint32_t precedence_rule = 1;
+		static const uint32_t precedence_rule_decision = 2;
+		static const uint32_t non_greedy = 4;
+
+		struct state
+		{
+			// The type of the state, or invalid for a state number which is not used.
+			atn_state::atn_state_type type;
+			uint32_t rule_index;
+
+			// The end state of a block start, the start state of a block end, or the stop state of a rule start.
+			uint32_t end_state;
+
+			// The loop back state of a plus block start, star loop entry or loop end.
+			uint32_t loopback_state;
+
+			// The precedence_rule, precedence_rule_decision and non_greedy flags which apply to the state.
+			uint32_t flags;
+		};
+
+		atn_type grammar_type;
+		int32_t max_token_type;
+
+		size_t state_count;
+		state const* states;
+
+		// The transitions of each state, in the layout of transition_table.
+		uint32_t const* transition_offsets;
+		transition_table::entry const* transitions;
+		size_t interval_count;
+		transition_table::interval const* intervals;
+
+		// The unoptimized transitions of each state in the same layout, which keep the alternative numbering of the
+		// decisions for the static analyses. Null when no state was optimized, so the transitions above serve for both.
+		uint32_t const* alternative_transition_offsets;
+		transition_table::entry const* alternative_transitions;
+		size_t alternative_interval_count;
+		transition_table::interval const* alternative_intervals;
+
+		size_t rule_count;
+		uint32_t const* rule_start_states;
+
+		size_t decision_count;
+		uint32_t const* decision_states;
+
+		// The lexer actions of a lexer grammar by action index. The operand of custom actions is their action index, for
+		// use with a lexer_custom_action_table.
+		size_t lexer_action_count;
+		lexer_action_code const* lexer_actions;
+
+		// Creates the states of the ATN with their transition views over the static arrays. No transition objects are
+		// created: prediction reads the views, and the static analyses walk the transition tables.
+		std::unique_ptr<grammar_atn> instantiate() const;
+
+	public:
+		// The record describing state.
+		static state describe(atn_state const& state);
+
+		// Whether states of type are decision states.
+		static bool decision(atn_state::atn_state_type type);
+
+		// The code of a lexer action of the ATN, where custom actions are encoded by their action index.
+		static lexer_action_code encode(lexer_action const& action);
+
+		// Creates the state described by record, or returns null for an unused state number.
+		static std::shared_ptr<atn_state> create_state(state const& record, size_t state_number);
+
+		// Links state to the states named by its record, which must already exist in atn.
+		static void link_state(grammar_atn const& atn, state const& record, atn_state& state);
+	};
+
+}
+}
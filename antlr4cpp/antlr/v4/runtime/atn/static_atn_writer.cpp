@@ -0,0 +1,316 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+
+#include <antlr/v4/runtime/atn/static_atn_writer.hpp>
+
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/lexer_action.hpp>
+#include <antlr/v4/runtime/atn/static_atn.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	namespace {
+
+		char const* atn_type_name(atn_type type)
+		{
+			switch (type)
+			{
+			case atn_type::lexer:
+				return "antlr4::atn::atn_type::lexer";
+
+			case atn_type::parser:
+				return "antlr4::atn::atn_type::parser";
+
+			default:
+				assert(!"Invalid ATN type.");
+				return "antlr4::atn::atn_type::parser";
+			}
+		}
+
+		char const* state_type_name(atn_state::atn_state_type type)
+		{
+			switch (type)
+			{
+			case atn_state::atn_state_type::basic:
+				return "antlr4::atn::atn_state::atn_state_type::basic";
+
+			case atn_state::atn_state_type::rule_start:
+				return "antlr4::atn::atn_state::atn_state_type::rule_start";
+
+			case atn_state::atn_state_type::block_start:
+				return "antlr4::atn::atn_state::atn_state_type::block_start";
+
+			case atn_state::atn_state_type::plus_block_start:
+				return "antlr4::atn::atn_state::atn_state_type::plus_block_start";
+
+			case atn_state::atn_state_type::star_block_start:
+				return "antlr4::atn::atn_state::atn_state_type::star_block_start";
+
+			case atn_state::atn_state_type::token_start:
+				return "antlr4::atn::atn_state::atn_state_type::token_start";
+
+			case atn_state::atn_state_type::rule_stop:
+				return "antlr4::atn::atn_state::atn_state_type::rule_stop";
+
+			case atn_state::atn_state_type::block_end:
+				return "antlr4::atn::atn_state::atn_state_type::block_end";
+
+			case atn_state::atn_state_type::star_loop_back:
+				return "antlr4::atn::atn_state::atn_state_type::star_loop_back";
+
+			case atn_state::atn_state_type::star_loop_entry:
+				return "antlr4::atn::atn_state::atn_state_type::star_loop_entry";
+
+			case atn_state::atn_state_type::plus_loop_back:
+				return "antlr4::atn::atn_state::atn_state_type::plus_loop_back";
+
+			case atn_state::atn_state_type::loop_end:
+				return "antlr4::atn::atn_state::atn_state_type::loop_end";
+
+			case atn_state::atn_state_type::invalid:
+			default:
+				return "antlr4::atn::atn_state::atn_state_type::invalid";
+			}
+		}
+
+		char const* transition_type_name(transition::transition_type type)
+		{
+			switch (type)
+			{
+			case transition::transition_type::epsilon:
+				return "antlr4::atn::transition::transition_type::epsilon";
+
+			case transition::transition_type::range:
+				return "antlr4::atn::transition::transition_type::range";
+
+			case transition::transition_type::rule:
+				return "antlr4::atn::transition::transition_type::rule";
+
+			case transition::transition_type::predicate:
+				return "antlr4::atn::transition::transition_type::predicate";
+
+			case transition::transition_type::atom:
+				return "antlr4::atn::transition::transition_type::atom";
+
+			case transition::transition_type::action:
+				return "antlr4::atn::transition::transition_type::action";
+
+			case transition::transition_type::set:
+				return "antlr4::atn::transition::transition_type::set";
+
+			case transition::transition_type::not_set:
+				return "antlr4::atn::transition::transition_type::not_set";
+
+			case transition::transition_type::wildcard:
+				return "antlr4::atn::transition::transition_type::wildcard";
+
+			case transition::transition_type::precedence:
+				return "antlr4::atn::transition::transition_type::precedence";
+
+			default:
+				assert(!"Invalid transition type.");
+				return "antlr4::atn::transition::transition_type::epsilon";
+			}
+		}
+
+		char const* lexer_action_type_name(lexer_action::lexer_action_type type)
+		{
+			switch (type)
+			{
+			case lexer_action::lexer_action_type::channel:
+				return "antlr4::atn::lexer_action::lexer_action_type::channel";
+
+			case lexer_action::lexer_action_type::mode:
+				return "antlr4::atn::lexer_action::lexer_action_type::mode";
+
+			case lexer_action::lexer_action_type::more:
+				return "antlr4::atn::lexer_action::lexer_action_type::more";
+
+			case lexer_action::lexer_action_type::pop_mode:
+				return "antlr4::atn::lexer_action::lexer_action_type::pop_mode";
+
+			case lexer_action::lexer_action_type::push_mode:
+				return "antlr4::atn::lexer_action::lexer_action_type::push_mode";
+
+			case lexer_action::lexer_action_type::skip:
+				return "antlr4::atn::lexer_action::lexer_action_type::skip";
+
+			case lexer_action::lexer_action_type::type:
+				return "antlr4::atn::lexer_action::lexer_action_type::type";
+
+			case lexer_action::lexer_action_type::custom:
+				return "antlr4::atn::lexer_action::lexer_action_type::custom";
+
+			default:
+				assert(!"Invalid lexer action type.");
+				return "antlr4::atn::lexer_action::lexer_action_type::custom";
+			}
+		}
+
+		// Writes "nullptr" in place of an empty array, which C++ does not allow to be defined.
+		void write_array_name(std::ostream& out, std::string const& name, char const* suffix, size_t size)
+		{
+			if (size == 0)
+			{
+				out << "nullptr";
+			}
+			else
+			{
+				out << name << suffix;
+			}
+		}
+
+		void write_numbers(std::ostream& out, std::string const& name, char const* suffix, std::vector<uint32_t> const& values)
+		{
+			if (values.empty())
+			{
+				return;
+			}
+
+			out << "\tconst uint32_t " << name << suffix << "[] =\n\t{\n";
+			for each (uint32_t value in values)
+			{
+				out << "\t\t" << value << "u,\n";
+			}
+
+			out << "\t};\n\n";
+		}
+
+		// Writes the offsets, entries and intervals of table as the arrays prefix_transition_offsets,
+		// prefix_transitions and prefix_intervals.
+		void write_table(std::ostream& out, std::string const& prefix, transition_table const& table)
+		{
+			std::vector<uint32_t> offsets(table.offsets(), table.offsets() + table.state_count() + 1);
+			write_numbers(out, prefix, "_transition_offsets", offsets);
+
+			if (table.size() > 0)
+			{
+				out << "\tconst antlr4::atn::transition_table::entry " << prefix << "_transitions[] =\n\t{\n";
+				for (size_t i = 0; i < table.size(); i++)
+				{
+					transition_table::entry const& entry = table.entries()[i];
+					out << "\t\t{ " << transition_type_name(entry.type) << ", " << static_cast<uint32_t>(entry.flags) << "u, 0, " << entry.target << "u, " << entry.first << ", " << entry.second << " },\n";
+				}
+
+				out << "\t};\n\n";
+			}
+
+			if (table.interval_count() > 0)
+			{
+				out << "\tconst antlr4::atn::transition_table::interval " << prefix << "_intervals[] =\n\t{\n";
+				for (size_t i = 0; i < table.interval_count(); i++)
+				{
+					out << "\t\t{ " << table.intervals()[i].first << ", " << table.intervals()[i].second << " },\n";
+				}
+
+				out << "\t};\n\n";
+			}
+		}
+
+		// Writes the static_atn fields naming the arrays written by write_table.
+		void write_table_fields(std::ostream& out, std::string const& prefix, transition_table const& table)
+		{
+			out << "\t" << prefix << "_transition_offsets,\n\t";
+			write_array_name(out, prefix, "_transitions", table.size());
+			out << ",\n\t" << table.interval_count() << ",\n\t";
+			write_array_name(out, prefix, "_intervals", table.interval_count());
+			out << ",\n";
+		}
+
+	}
+
+	void static_atn_writer::write(std::ostream& out, std::string const& name, grammar_atn const& atn, std::vector<std::shared_ptr<lexer_action>> const& lexer_actions)
+	{
+		transition_table const* table = atn.transition_table();
+		assert(table && table->state_count() == atn.states().size());
+
+		out << "namespace {\n\n";
+
+		if (!atn.states().empty())
+		{
+			out << "\tconst antlr4::atn::static_atn::state " << name << "_states[] =\n\t{\n";
+			for each (std::shared_ptr<atn_state> const& state in atn.states())
+			{
+				static_atn::state description = state ? static_atn::describe(*state) : static_atn::state { atn_state::atn_state_type::invalid, 0, static_atn::no_state, static_atn::no_state, 0 };
+				out << "\t\t{ " << state_type_name(description.type) << ", " << description.rule_index << "u, " << description.end_state << "u, " << description.loopback_state << "u, " << description.flags << "u },\n";
+			}
+
+			out << "\t};\n\n";
+		}
+
+		write_table(out, name, *table);
+
+		// the static analyses number the alternatives of the decisions by the unoptimized transitions
+		transition_table const* alternative_table = atn.alternative_table() != table ? atn.alternative_table() : nullptr;
+		if (alternative_table)
+		{
+			write_table(out, name + "_alternative", *alternative_table);
+		}
+
+		std::vector<uint32_t> rule_start_states;
+		for each (std::shared_ptr<rule_start_state> const& state in atn.rule_start_states())
+		{
+			rule_start_states.push_back(static_cast<uint32_t>(state->state_number()));
+		}
+
+		write_numbers(out, name, "_rule_start_states", rule_start_states);
+
+		std::vector<uint32_t> decision_states;
+		for each (std::shared_ptr<decision_state> const& state in atn.decision_states())
+		{
+			decision_states.push_back(static_cast<uint32_t>(state->state_number()));
+		}
+
+		write_numbers(out, name, "_decision_states", decision_states);
+
+		if (!lexer_actions.empty())
+		{
+			out << "\tconst antlr4::atn::lexer_action_code " << name << "_lexer_actions[] =\n\t{\n";
+			for each (std::shared_ptr<lexer_action> const& action in lexer_actions)
+			{
+				assert(action->action_type() != lexer_action::lexer_action_type::indexed_custom);
+				out << "\t\t{ " << lexer_action_type_name(action->action_type()) << ", " << static_atn::encode(*action).operand << " },\n";
+			}
+
+			out << "\t};\n\n";
+		}
+
+		out << "}\n\n";
+
+		out << "extern const antlr4::atn::static_atn " << name << " =\n{\n";
+		out << "\t" << atn_type_name(atn.grammar_type()) << ",\n";
+		out << "\t" << atn.max_token_type() << ",\n";
+		out << "\t" << atn.states().size() << ",\n\t";
+		write_array_name(out, name, "_states", atn.states().size());
+		out << ",\n";
+		write_table_fields(out, name, *table);
+		if (alternative_table)
+		{
+			write_table_fields(out, name + "_alternative", *alternative_table);
+		}
+		else
+		{
+			out << "\tnullptr,\n\tnullptr,\n\t0,\n\tnullptr,\n";
+		}
+
+		out << "\t" << rule_start_states.size() << ",\n\t";
+		write_array_name(out, name, "_rule_start_states", rule_start_states.size());
+		out << ",\n\t" << decision_states.size() << ",\n\t";
+		write_array_name(out, name, "_decision_states", decision_states.size());
+		out << ",\n\t" << lexer_actions.size() << ",\n\t";
+		write_array_name(out, name, "_lexer_actions", lexer_actions.size());
+		out << ",\n};\n";
+	}
+
+}
+}
@@ -0,0 +1,26 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+	class lexer_action;
+
+	// Emits the ATN of a grammar as C++ source defining a static_atn over constant arrays, for inclusion in the code
+	// generated for the grammar. The ATN must have its transition table built.
+	class static_atn_writer
+	{
+	public:
+		// Writes the arrays into an anonymous namespace followed by the definition of the static_atn name, which is
+		// declared extern so the recognizer can refer to it from another translation unit.
+		static void write(std::ostream& out, std::string const& name, grammar_atn const& atn, std::vector<std::shared_ptr<lexer_action>> const& lexer_actions);
+	};
+
+}
+}
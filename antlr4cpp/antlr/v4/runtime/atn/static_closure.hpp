@@ -0,0 +1,129 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "atn_state.hpp"
+#include "grammar_atn.hpp"
+#include "transition.hpp"
+#include "transition_table.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	// The Path of a walker which accumulates nothing along a path.
+	struct empty_path
+	{
+	};
+
+	// Walks the states of a parser ATN reachable from a point without consuming input, as the static analyses do
+	// before any input is seen. The walk reads the alternative table of the ATN, so it needs no transition objects, and
+	// tracks the follow states of the rule invocations entered on the way, visiting each state once for each stack it
+	// is reached with. A rule stop state reached with an invocation pending returns to its follow state; reached
+	// without one, the rule may be the start rule, or invoked from any of the follow states it returns to, so the
+	// walker decides what to do with it.
+	//
+	// Walker derives from this class and provides
+	//
+	//   bool enter(atn_state const& state, Path const& path)
+	//     Called for each state reached, other than a rule stop state returning to a pending invocation. Returns
+	//     whether to follow the transitions of state.
+	//
+	//   void follow(transition_table::entry const& transition, Path const& path)
+	//     Called for each transition followed other than a rule transition, which the walk follows itself. Continues
+	//     the walk by calling closure on the target of transition.
+	//
+	// Path carries whatever the walker accumulates along a path, such as the predicates passed.
+	template<typename Walker, typename Path>
+	class static_closure
+	{
+	private:
+		grammar_atn const& _atn;
+		transition_table const* _table;
+		std::vector<size_t> _stack;
+		std::set<std::pair<size_t, std::vector<size_t>>> _busy;
+
+	protected:
+		// The transition table of atn must have been built.
+		explicit static_closure(grammar_atn const& atn)
+			: _atn(atn)
+			, _table(atn.alternative_table())
+		{
+			assert(_table);
+		}
+
+	public:
+		grammar_atn const& atn() const
+		{
+			return _atn;
+		}
+
+		// The transitions walked, as the grammar defines them.
+		transition_table const& table() const
+		{
+			return *_table;
+		}
+
+		// The follow states of the rule invocations entered on the current path, innermost last.
+		std::vector<size_t> const& stack() const
+		{
+			return _stack;
+		}
+
+		// Starts a new walk with stack pending, forgetting the states visited by earlier walks.
+		void reset(std::vector<size_t> const& stack = std::vector<size_t>())
+		{
+			_stack = stack;
+			_busy.clear();
+		}
+
+		void closure(size_t state_number, Path const& path)
+		{
+			if (!_busy.insert(std::make_pair(state_number, _stack)).second)
+			{
+				return;
+			}
+
+			// every state is walked, so the states of a binary_atn must all have been materialized
+			assert(_atn.state(state_number));
+			atn_state const& state = *_atn.state(state_number);
+			if (state.state_type() == atn_state::atn_state_type::rule_stop && !_stack.empty())
+			{
+				size_t follow_state = _stack.back();
+				_stack.pop_back();
+				closure(follow_state, path);
+				_stack.push_back(follow_state);
+				return;
+			}
+
+			if (!static_cast<Walker&>(*this).enter(state, path))
+			{
+				return;
+			}
+
+			for each (transition_table::entry const& transition in _table->transitions(static_cast<uint32_t>(state_number)))
+			{
+				closure(transition, path);
+			}
+		}
+
+		void closure(transition_table::entry const& transition, Path const& path)
+		{
+			if (transition.type == transition::transition_type::rule)
+			{
+				_stack.push_back(static_cast<size_t>(transition.first));
+				closure(transition.target, path);
+				_stack.pop_back();
+				return;
+			}
+
+			static_cast<Walker&>(*this).follow(transition, path);
+		}
+	};
+
+}
+}
@@ -1,7 +1,12 @@
 // Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <utility>
+
+#include "../misc/interval_set.hpp"
 #include "semantic_context.hpp"
 
 namespace antlr4 {
@@ -12,7 +17,7 @@ namespace atn {
 
 	class transition {
 	public:
-		enum class transition_type
+		enum class transition_type : uint8_t
 		{
 			epsilon = 1,
 			range,
@@ -50,7 +55,13 @@ namespace atn {
 
 		bool epsilon() const
 		{
-			switch (type())
+			return epsilon(type());
+		}
+
+		// Determines whether transitions of type are followed without consuming input.
+		static bool epsilon(transition_type type)
+		{
+			switch (type)
 			{
 			case transition_type::epsilon:
 			case transition_type::rule:
@@ -69,6 +80,8 @@ namespace atn {
 			}
 		}
 
+		// Determines whether this transition consumes symbol. The check is a switch on the type, with the atom and range
+		// cases first since they make up most of the transitions that consume input.
 		bool matches(int32_t symbol, int32_t min_vocab, int32_t max_vocab) const;
 	};
 
@@ -91,6 +104,14 @@ namespace atn {
 		}
 	};
 
+	// Determines whether transition is an epsilon transition which does not leave a precedence rule, so the
+	// transitions it leads to can be followed in its place.
+	inline bool is_plain_epsilon(transition const& transition)
+	{
+		return transition.type() == transition::transition_type::epsilon
+			&& static_cast<epsilon_transition const&>(transition).outermost_precedence_return() == -1;
+	}
+
 	class range_transition : public transition
 	{
 	private:
@@ -126,6 +147,8 @@ namespace atn {
 			, _rule_index(rule_index)
 			, _precedence(precedence)
 			, _follow_state(follow_state)
+			, _tail_call(false)
+			, _optimized_tail_call(false)
 		{
 		}
 
@@ -254,27 +277,73 @@ namespace atn {
 
 	class set_transition : public transition
 	{
+	private:
+		const std::shared_ptr<misc::interval_set<int32_t> const> _label;
+
+		// The set of symbols this transition matches, which is the label itself except for not_set_transition, and its
+		// members below 128 as a bitmap so the common case is matched with a single bit test.
+		const std::shared_ptr<misc::interval_set<int32_t> const> _match_set;
+		uint64_t _ascii[2];
+
 	public:
-		explicit set_transition(std::shared_ptr<atn_state> const& target)
-			: set_transition(transition_type::epsilon, target)
+		// The label is shared by all transitions with the same set, as read by the deserializer.
+		explicit set_transition(std::shared_ptr<atn_state> const& target, std::shared_ptr<misc::interval_set<int32_t> const> const& label)
+			: set_transition(transition_type::set, target, label, label)
 		{
 		}
 
 	protected:
-		explicit set_transition(transition_type type, std::shared_ptr<atn_state> const& target)
+		explicit set_transition(transition_type type, std::shared_ptr<atn_state> const& target, std::shared_ptr<misc::interval_set<int32_t> const> const& label, std::shared_ptr<misc::interval_set<int32_t> const> const& match_set)
 			: transition(type, target)
+			, _label(label)
+			, _match_set(match_set)
 		{
-			throw std::runtime_error("not implemented");
+			_ascii[0] = 0;
+			_ascii[1] = 0;
+			for each (misc::interval_set<int32_t>::interval_type const& interval in _match_set->pairs())
+			{
+				for (int32_t symbol = std::max(interval.first, 0); symbol < std::min(interval.second, 128); symbol++)
+				{
+					_ascii[symbol >> 6] |= static_cast<uint64_t>(1) << (symbol & 63);
+				}
+			}
+		}
+
+	public:
+		misc::interval_set<int32_t> const& label() const
+		{
+			return *_label;
+		}
+
+		std::shared_ptr<misc::interval_set<int32_t> const> const& shared_label() const
+		{
+			return _label;
+		}
+
+		misc::interval_set<int32_t> const& match_set() const
+		{
+			return *_match_set;
+		}
+
+		bool contains(int32_t symbol) const
+		{
+			if (static_cast<uint32_t>(symbol) < 128)
+			{
+				return ((_ascii[symbol >> 6] >> (symbol & 63)) & 1) != 0;
+			}
+
+			return _match_set->contains(symbol);
 		}
 	};
 
 	class not_set_transition : public set_transition
 	{
 	public:
-		explicit not_set_transition(std::shared_ptr<atn_state> const& target)
-			: set_transition(transition_type::not_set, target)
+		// The complement of the label is resolved against the vocabulary [min_vocab, max_vocab] when the transition is
+		// created, so matching does not depend on the vocabulary passed to matches.
+		explicit not_set_transition(std::shared_ptr<atn_state> const& target, std::shared_ptr<misc::interval_set<int32_t> const> const& label, int32_t min_vocab, int32_t max_vocab)
+			: set_transition(transition_type::not_set, target, label, std::make_shared<misc::interval_set<int32_t>>(misc::interval_set<int32_t>::complement(*label, std::make_pair(min_vocab, max_vocab + 1))))
 		{
-			throw std::runtime_error("not implemented");
 		}
 	};
 
@@ -282,7 +351,7 @@ namespace atn {
 	{
 	public:
 		explicit wildcard_transition(std::shared_ptr<atn_state> const& target)
-			: transition(transition_type::epsilon, target)
+			: transition(transition_type::wildcard, target)
 		{
 		}
 	};
@@ -291,11 +360,13 @@ namespace atn {
 	{
 	private:
 		const int32_t _precedence;
+		const std::shared_ptr<semantic_context::precedence_predicate> _predicate;
 
 	public:
 		explicit precedence_transition(std::shared_ptr<atn_state> const& target, int32_t precedence)
-			: transition(transition_type::epsilon, target)
+			: transition(transition_type::precedence, target)
 			, _precedence(precedence)
+			, _predicate(semantic_context::precedence_predicate::instance(precedence))
 		{
 		}
 
@@ -305,11 +376,41 @@ namespace atn {
 			return _precedence;
 		}
 
-		std::shared_ptr<semantic_context::precedence_predicate> predicate() const
+		std::shared_ptr<semantic_context::precedence_predicate> const& predicate() const
 		{
-			return std::make_shared<semantic_context::precedence_predicate>(precedence());
+			return _predicate;
 		}
 	};
 
+	inline bool transition::matches(int32_t symbol, int32_t min_vocab, int32_t max_vocab) const
+	{
+		switch (type())
+		{
+		case transition_type::atom:
+			return static_cast<atom_transition const*>(this)->label() == symbol;
+
+		case transition_type::range:
+		{
+			std::pair<int32_t, int32_t> label = static_cast<range_transition const*>(this)->label();
+			return symbol >= label.first && symbol < label.second;
+		}
+
+		case transition_type::set:
+		case transition_type::not_set:
+			return static_cast<set_transition const*>(this)->contains(symbol);
+
+		case transition_type::wildcard:
+			return symbol >= min_vocab && symbol <= max_vocab;
+
+		case transition_type::epsilon:
+		case transition_type::rule:
+		case transition_type::predicate:
+		case transition_type::action:
+		case transition_type::precedence:
+		default:
+			return false;
+		}
+	}
+
 }
 }
@@ -0,0 +1,129 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <limits>
+
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace atn {
+
+	const uint8_t transition_table::context_dependent;
+	const uint8_t transition_table::tail_call;
+	const uint8_t transition_table::optimized_tail_call;
+
+	namespace {
+
+		transition_table::entry make_entry(transition const& transition, std::vector<transition_table::interval>& intervals)
+		{
+			assert(transition.target()->state_number() < std::numeric_limits<uint32_t>::max());
+
+			transition_table::entry result = { transition.type(), 0, 0, static_cast<uint32_t>(transition.target()->state_number()), 0, 0 };
+			switch (transition.type())
+			{
+			case transition::transition_type::atom:
+				result.first = static_cast<atom_transition const&>(transition).label();
+				result.second = result.first + 1;
+				break;
+
+			case transition::transition_type::range:
+				result.first = static_cast<range_transition const&>(transition).label().first;
+				result.second = static_cast<range_transition const&>(transition).label().second;
+				break;
+
+			case transition::transition_type::set:
+			case transition::transition_type::not_set:
+				result.first = static_cast<int32_t>(intervals.size());
+				for each (misc::interval_set<int32_t>::interval_type const& interval in static_cast<set_transition const&>(transition).match_set().pairs())
+				{
+					intervals.push_back(transition_table::interval { interval.first, interval.second });
+				}
+
+				result.second = static_cast<int32_t>(intervals.size());
+				break;
+
+			case transition::transition_type::rule:
+				result.flags = static_cast<uint8_t>((static_cast<rule_transition const&>(transition).tail_call() ? transition_table::tail_call : 0)
+					| (static_cast<rule_transition const&>(transition).optimized_tail_call() ? transition_table::optimized_tail_call : 0));
+				result.first = static_cast<int32_t>(static_cast<rule_transition const&>(transition).follow_state()->state_number());
+				result.second = static_cast<rule_transition const&>(transition).precedence();
+				break;
+
+			case transition::transition_type::predicate:
+				result.flags = static_cast<predicate_transition const&>(transition).context_dependent() ? transition_table::context_dependent : 0;
+				result.first = static_cast<int32_t>(static_cast<predicate_transition const&>(transition).rule_index());
+				result.second = static_cast<int32_t>(static_cast<predicate_transition const&>(transition).predicate_index());
+				break;
+
+			case transition::transition_type::action:
+				result.flags = static_cast<action_transition const&>(transition).context_dependent() ? transition_table::context_dependent : 0;
+				result.first = static_cast<int32_t>(static_cast<action_transition const&>(transition).rule_index());
+				result.second = static_cast<int32_t>(static_cast<action_transition const&>(transition).action_index());
+				break;
+
+			case transition::transition_type::precedence:
+				result.first = static_cast<precedence_transition const&>(transition).precedence();
+				break;
+
+			case transition::transition_type::epsilon:
+				result.first = static_cast<epsilon_transition const&>(transition).outermost_precedence_return();
+				break;
+
+			default:
+				break;
+			}
+
+			return result;
+		}
+
+	}
+
+	transition_table::transition_table(grammar_atn const& atn, transition_list list)
+	{
+		assert(atn.states().size() < std::numeric_limits<uint32_t>::max());
+
+		_offset_storage.reserve(atn.states().size() + 1);
+		for each (std::shared_ptr<atn_state> const& state in atn.states())
+		{
+			_offset_storage.push_back(static_cast<uint32_t>(_entry_storage.size()));
+			if (!state)
+			{
+				continue;
+			}
+
+			for each (std::shared_ptr<transition> const& transition in (list == transition_list::optimized ? state->optimized_transitions() : state->transitions()))
+			{
+				_entry_storage.push_back(make_entry(*transition, _interval_storage));
+			}
+		}
+
+		assert(_entry_storage.size() < std::numeric_limits<uint32_t>::max());
+		_offset_storage.push_back(static_cast<uint32_t>(_entry_storage.size()));
+
+		_state_count = atn.states().size();
+		_offsets = _offset_storage.data();
+		_entries = _entry_storage.data();
+		_interval_count = _interval_storage.size();
+		_intervals = _interval_storage.data();
+	}
+
+	transition_table::transition_table(size_t state_count, uint32_t const* offsets, entry const* entries, size_t interval_count, interval const* intervals)
+		: _state_count(state_count)
+		, _offsets(offsets)
+		, _entries(entries)
+		, _interval_count(interval_count)
+		, _intervals(intervals)
+	{
+	}
+
+}
+}
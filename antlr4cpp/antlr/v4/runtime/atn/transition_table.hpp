@@ -0,0 +1,251 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "transition.hpp"
+
+namespace antlr4 {
+namespace atn {
+
+	class grammar_atn;
+
+	// The transitions of every state of an ATN, stored contiguously in state order. Each state owns the range of entries
+	// from its offset to the offset of the next state, and entries refer to their target by state number instead of
+	// through a shared_ptr, so walking the ATN reads sequential memory without touching reference counts.
+	//
+	// The table is built from a finished ATN; changes made to the states afterwards are not reflected in it.
+	class transition_table
+	{
+		transition_table(transition_table const&) = delete;
+		transition_table& operator= (transition_table const&) = delete;
+
+	public:
+		// The transitions of the states a table is built from.
+		enum class transition_list
+		{
+			// The transitions as the grammar defines them, where alternative n + 1 of a decision is entered through
+			// transition n. The static analyses of the ATN walk these.
+			alternatives,
+
+			// The transitions left by atn_optimizer, which prediction follows.
+			optimized,
+		};
+
+		// A half-open range [first, second) of the symbols matched by a set or not_set transition.
+		struct interval
+		{
+			int32_t first;
+			int32_t second;
+		};
+
+		// The flags of an entry.
+		static const uint8_t context_dependent = 1;
+		static const uint8_t tail_call = 2;
+		static const uint8_t optimized_tail_call = 4;
+
+		// An entry has no padding and no pointers, so arrays of entries are the same bytes on every run, and can be
+		// written to a binary image and viewed from it in place.
+		struct entry
+		{
+			transition::transition_type type;
+
+			// The context_dependent flag of a predicate or action transition whose predicate or action depends on the
+			// rule context, or the tail_call and optimized_tail_call flags of a rule transition.
+			uint8_t flags;
+
+			// Always zero.
+			uint16_t reserved;
+
+			uint32_t target;
+
+			// The operands of the transition, by type:
+			//   atom, range      the label as the half-open range [first, second)
+			//   set, not_set     the symbols matched, as the intervals [first, second) of the interval table
+			//   rule             the follow state and the precedence
+			//   predicate        the rule index and the predicate index
+			//   action           the rule index and the action index
+			//   precedence       the precedence
+			//   epsilon          the outermost precedence return
+			// Unused operands are zero.
+			int32_t first;
+			int32_t second;
+		};
+
+		static_assert(sizeof(entry) == 16, "A transition table entry must not contain padding.");
+
+		// A non-owning view of the entries of one state.
+		class view
+		{
+		private:
+			entry const* _begin;
+			entry const* _end;
+
+		public:
+			view()
+				: _begin(nullptr)
+				, _end(nullptr)
+			{
+			}
+
+			view(entry const* begin, entry const* end)
+				: _begin(begin)
+				, _end(end)
+			{
+			}
+
+		public:
+			entry const* begin() const
+			{
+				return _begin;
+			}
+
+			entry const* end() const
+			{
+				return _end;
+			}
+
+			size_t size() const
+			{
+				return static_cast<size_t>(_end - _begin);
+			}
+
+			bool empty() const
+			{
+				return _begin == _end;
+			}
+
+			entry const& operator[] (size_t index) const
+			{
+				assert(index < size());
+				return _begin[index];
+			}
+		};
+
+	private:
+		// A table built from an ATN owns its arrays; a table over static arrays leaves these empty.
+		std::vector<uint32_t> _offset_storage;
+		std::vector<entry> _entry_storage;
+		std::vector<interval> _interval_storage;
+
+		size_t _state_count;
+		uint32_t const* _offsets;
+		entry const* _entries;
+		size_t _interval_count;
+		interval const* _intervals;
+
+	public:
+		explicit transition_table(grammar_atn const& atn, transition_list list = transition_list::optimized);
+
+		// Views arrays which outlive the table, such as those emitted by static_atn_writer, without copying them. There are
+		// state_count + 1 offsets, the last being the number of entries.
+		transition_table(size_t state_count, uint32_t const* offsets, entry const* entries, size_t interval_count, interval const* intervals);
+
+	public:
+		size_t state_count() const
+		{
+			return _state_count;
+		}
+
+		size_t size() const
+		{
+			return _offsets[_state_count];
+		}
+
+		size_t interval_count() const
+		{
+			return _interval_count;
+		}
+
+		uint32_t const* offsets() const
+		{
+			return _offsets;
+		}
+
+		entry const* entries() const
+		{
+			return _entries;
+		}
+
+		interval const* intervals() const
+		{
+			return _intervals;
+		}
+
+		view transitions(uint32_t state_number) const
+		{
+			assert(state_number < state_count());
+			return view(_entries + _offsets[state_number], _entries + _offsets[state_number + 1]);
+		}
+
+		// Whether state_number has transitions, all of which are followed without consuming input.
+		bool only_epsilon(uint32_t state_number) const
+		{
+			view transitions = this->transitions(state_number);
+			return !transitions.empty() && std::all_of(transitions.begin(), transitions.end(),
+				[](entry const& entry)
+				{
+					return transition::epsilon(entry.type);
+				});
+		}
+
+		// Appends to states the target of each transition of state_number which consumes symbol.
+		void next_states(uint32_t state_number, int32_t symbol, int32_t min_vocab, int32_t max_vocab, std::vector<uint32_t>& states) const
+		{
+			for each (entry const& transition in transitions(state_number))
+			{
+				if (matches(transition, symbol, min_vocab, max_vocab))
+				{
+					states.push_back(transition.target);
+				}
+			}
+		}
+
+		// Determines whether the transition of entry consumes symbol. Atom and range transitions are matched against
+		// the label stored in the entry itself, and sets against their intervals.
+		bool matches(entry const& entry, int32_t symbol, int32_t min_vocab, int32_t max_vocab) const
+		{
+			switch (entry.type)
+			{
+			case transition::transition_type::atom:
+			case transition::transition_type::range:
+				return symbol >= entry.first && symbol < entry.second;
+
+			case transition::transition_type::wildcard:
+				return symbol >= min_vocab && symbol <= max_vocab;
+
+			case transition::transition_type::set:
+			case transition::transition_type::not_set:
+				return contains(entry, symbol);
+
+			default:
+				return false;
+			}
+		}
+
+	private:
+		bool contains(entry const& entry, int32_t symbol) const
+		{
+			interval const* begin = _intervals + entry.first;
+			interval const* end = _intervals + entry.second;
+			interval const* next = std::upper_bound(begin, end, symbol,
+				[](int32_t x, interval const& interval)
+				{
+					return x < interval.first;
+				});
+			return next != begin && symbol < (next - 1)->second;
+		}
+	};
+
+	// Determines whether entry is an epsilon transition which does not leave a precedence rule.
+	inline bool is_plain_epsilon(transition_table::entry const& entry)
+	{
+		return entry.type == transition::transition_type::epsilon && entry.first == -1;
+	}
+
+}
+}
@@ -0,0 +1,220 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#include "stdafx.h"
+
+#include <cassert>
+#include <set>
+#include <utility>
+
+#include <antlr/v4/runtime/dfa/decision_dfa.hpp>
+
+#include <antlr/v4/runtime/atn/atn_state.hpp>
+#include <antlr/v4/runtime/atn/grammar_atn.hpp>
+#include <antlr/v4/runtime/atn/semantic_context.hpp>
+#include <antlr/v4/runtime/atn/static_closure.hpp>
+#include <antlr/v4/runtime/atn/transition.hpp>
+#include <antlr/v4/runtime/atn/transition_table.hpp>
+
+#if defined(_MSC_VER) && (_MSC_VER == 1800)
+#undef assert
+#define assert(_Expression) (void)( (!!(_Expression)) || (_wassert(_CRT_WIDE(#_Expression), _CRT_WIDE(__FILE__), (unsigned)(__LINE__)), 0) )
+#endif
+
+namespace antlr4 {
+namespace dfa {
+
+	namespace {
+
+		// Sentinel for the start state of a decision which is not a precedence DFA.
+		const int32_t no_precedence = -1;
+
+		bool is_precedence_decision(atn::decision_state const& state)
+		{
+			return state.state_type() == atn::atn_state::atn_state_type::star_loop_entry
+				&& static_cast<atn::star_loop_entry_state const&>(state).precedence_rule_decision();
+		}
+
+		// Computes the configurations reached from the decision state without consuming input, carrying the predicates
+		// passed on the way. Rule stop states are kept as configurations when the stack is empty, as the decision does
+		// not know who invoked its rule.
+		class start_closure : public atn::static_closure<start_closure, std::shared_ptr<atn::semantic_context>>
+		{
+		private:
+			const int32_t _precedence;
+
+			size_t _alternative;
+			std::vector<start_configuration>& _configurations;
+
+		public:
+			start_closure(atn::grammar_atn const& atn, int32_t precedence, std::vector<start_configuration>& configurations)
+				: static_closure(atn)
+				, _precedence(precedence)
+				, _alternative(0)
+				, _configurations(configurations)
+			{
+			}
+
+		public:
+			// Adds the configurations of alternative, where the alternative n is entered through transition n - 1.
+			void add_alternative(atn::transition_table::entry const& transition, size_t alternative)
+			{
+				_alternative = alternative;
+				reset();
+				closure(transition, atn::semantic_context::none);
+			}
+
+		public:
+			bool enter(atn::atn_state const& state, std::shared_ptr<atn::semantic_context> const& context)
+			{
+				if (state.state_type() == atn::atn_state::atn_state_type::rule_stop || !table().only_epsilon(static_cast<uint32_t>(state.state_number())))
+				{
+					add(state, context);
+					return false;
+				}
+
+				return true;
+			}
+
+			void follow(atn::transition_table::entry const& transition, std::shared_ptr<atn::semantic_context> const& context)
+			{
+				switch (transition.type)
+				{
+				case atn::transition::transition_type::precedence:
+				{
+					int32_t level = transition.first;
+					if (_precedence == no_precedence)
+					{
+						closure(transition.target, atn::semantic_context::combine_and(context, atn::semantic_context::precedence_predicate::instance(level)));
+					}
+					else if (level >= _precedence)
+					{
+						// the predicate holds for every prediction made from this start state
+						closure(transition.target, context);
+					}
+
+					break;
+				}
+
+				case atn::transition::transition_type::predicate:
+				{
+					std::shared_ptr<atn::semantic_context> leaf = std::make_shared<atn::semantic_context::predicate>(transition.first, transition.second, (transition.flags & atn::transition_table::context_dependent) != 0);
+					closure(transition.target, atn::semantic_context::combine_and(context, leaf));
+					break;
+				}
+
+				case atn::transition::transition_type::epsilon:
+				case atn::transition::transition_type::action:
+					closure(transition.target, context);
+					break;
+
+				default:
+					assert(!"Invalid epsilon transition type.");
+					break;
+				}
+			}
+
+		private:
+			void add(atn::atn_state const& state, std::shared_ptr<atn::semantic_context> const& context)
+			{
+				_configurations.push_back(start_configuration { state.state_number(), _alternative, stack(), context });
+			}
+		};
+
+	}
+
+	decision_dfa::decision_dfa(atn::grammar_atn const& atn, size_t decision)
+		: _atn(atn)
+		, _decision_state(*atn.decision_states()[decision])
+		, _precedence_dfa(is_precedence_decision(*atn.decision_states()[decision]))
+	{
+	}
+
+	std::shared_ptr<start_state const> decision_dfa::start_state(int32_t precedence)
+	{
+		std::lock_guard<std::mutex> guard(_lock);
+		if (!_precedence_dfa)
+		{
+			if (!_start_state)
+			{
+				_start_state = build_start_state(no_precedence);
+			}
+
+			return _start_state;
+		}
+
+		assert(precedence >= 0);
+		size_t level = static_cast<size_t>(precedence);
+		if (level >= _precedence_start_states.size())
+		{
+			_precedence_start_states.resize(level + 1);
+		}
+
+		if (!_precedence_start_states[level])
+		{
+			_precedence_start_states[level] = build_start_state(precedence);
+		}
+
+		return _precedence_start_states[level];
+	}
+
+	size_t decision_dfa::start_state_count() const
+	{
+		std::lock_guard<std::mutex> guard(_lock);
+		if (!_precedence_dfa)
+		{
+			return _start_state ? 1 : 0;
+		}
+
+		size_t result = 0;
+		for each (std::shared_ptr<dfa::start_state const> const& state in _precedence_start_states)
+		{
+			if (state)
+			{
+				result++;
+			}
+		}
+
+		return result;
+	}
+
+	std::shared_ptr<start_state const> decision_dfa::build_start_state(int32_t precedence) const
+	{
+		std::vector<start_configuration> configurations;
+		start_closure closure(_atn, precedence, configurations);
+		atn::transition_table::view transitions = _atn.alternative_table()->transitions(static_cast<uint32_t>(_decision_state.state_number()));
+		for (size_t i = 0; i < transitions.size(); i++)
+		{
+			closure.add_alternative(transitions[i], i + 1);
+		}
+
+		if (precedence == no_precedence)
+		{
+			return std::make_shared<dfa::start_state>(std::move(configurations));
+		}
+
+		// the first alternative continues the operator loop, so the other alternatives are not viable where it can
+		// reach the same state in the same context
+		std::set<std::pair<size_t, std::vector<size_t>>> first_alternative;
+		for each (start_configuration const& configuration in configurations)
+		{
+			if (configuration.alternative == 1)
+			{
+				first_alternative.insert(std::make_pair(configuration.state, configuration.stack));
+			}
+		}
+
+		std::vector<start_configuration> filtered;
+		for each (start_configuration const& configuration in configurations)
+		{
+			if (configuration.alternative != 1 && first_alternative.count(std::make_pair(configuration.state, configuration.stack)) > 0)
+			{
+				continue;
+			}
+
+			filtered.push_back(configuration);
+		}
+
+		return std::make_shared<dfa::start_state>(std::move(filtered));
+	}
+
+}
+}
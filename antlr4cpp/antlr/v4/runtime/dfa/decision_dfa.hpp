@@ -0,0 +1,97 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace antlr4 {
+
+	namespace atn {
+		class decision_state;
+		class grammar_atn;
+		class semantic_context;
+	}
+
+namespace dfa {
+
+	// A configuration of the start state of a decision: an ATN state reached from the decision before any input is
+	// consumed, the alternative it was reached through, the follow states of the rules entered on the way, and the
+	// predicates which must hold for it.
+	struct start_configuration
+	{
+		size_t state;
+		size_t alternative;
+		std::vector<size_t> stack;
+		std::shared_ptr<atn::semantic_context> semantic_context;
+	};
+
+	class start_state
+	{
+		start_state(start_state const&) = delete;
+		start_state& operator= (start_state const&) = delete;
+
+	private:
+		const std::vector<start_configuration> _configurations;
+
+	public:
+		explicit start_state(std::vector<start_configuration>&& configurations)
+			: _configurations(std::move(configurations))
+		{
+		}
+
+	public:
+		std::vector<start_configuration> const& configurations() const
+		{
+			return _configurations;
+		}
+	};
+
+	// The start states of the DFA of one decision. The decision of the operator loop of a left-recursive rule, marked
+	// by star_loop_entry_state::precedence_rule_decision, is a precedence DFA: it keeps one start state for each
+	// precedence level the rule is invoked with, and the precedence predicates are evaluated against that level when
+	// the start state is built, so prediction never evaluates them again.
+	class decision_dfa
+	{
+		decision_dfa(decision_dfa const&) = delete;
+		decision_dfa& operator= (decision_dfa const&) = delete;
+
+	private:
+		atn::grammar_atn const& _atn;
+		atn::decision_state const& _decision_state;
+		const bool _precedence_dfa;
+
+		mutable std::mutex _lock;
+		std::shared_ptr<dfa::start_state const> _start_state;
+		std::vector<std::shared_ptr<dfa::start_state const>> _precedence_start_states;
+
+	public:
+		// The transition table of atn must have been built.
+		decision_dfa(atn::grammar_atn const& atn, size_t decision);
+
+	public:
+		atn::decision_state const& decision_state() const
+		{
+			return _decision_state;
+		}
+
+		bool precedence_dfa() const
+		{
+			return _precedence_dfa;
+		}
+
+		// Returns the start state, building it on first use. For a precedence DFA this is the start state for precedence,
+		// which is otherwise ignored. Safe to call from multiple threads.
+		std::shared_ptr<dfa::start_state const> start_state(int32_t precedence);
+
+		// The number of start states built so far.
+		size_t start_state_count() const;
+
+	private:
+		std::shared_ptr<dfa::start_state const> build_start_state(int32_t precedence) const;
+	};
+
+}
+}
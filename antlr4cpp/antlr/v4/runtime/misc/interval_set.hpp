@@ -103,24 +103,18 @@ namespace misc {
 
 		bool contains(_Ty value) const
 		{
-			// this could be greatly improved with a binary search
-			for each (interval_type const& pair in pairs())
-			{
-				if (value < pair.first)
-				{
-					// list is sorted and value is before this interval
-					return false;
-				}
-
-				// NOTE: duplicate range check omitted
-				if (/*value >= pair.first &&*/ value <= pair.second)
+			// the intervals are sorted and disjoint, so only the last one starting at or before value can contain it
+			auto iterator = std::upper_bound(_pairs.begin(), _pairs.end(), value,
+				[](_Ty x, interval_type const& pair)
 				{
-					// found in this interval
-					return true;
-				}
+					return x < pair.first;
+				});
+			if (iterator == _pairs.begin())
+			{
+				return false;
 			}
 
-			return false;
+			return value < (iterator - 1)->second;
 		}
 
 	public:
@@ -72,7 +72,7 @@ namespace misc {
 		}
 	};
 
-	bool operator== (uuid const& x, uuid const& y)
+	inline bool operator== (uuid const& x, uuid const& y)
 	{
 		if (x._a != y._a)
 			return false;
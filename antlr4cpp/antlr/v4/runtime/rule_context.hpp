@@ -0,0 +1,71 @@
+// Copyright (c) Terence Parr, Sam Harwell. Licensed under the BSD license. See LICENSE in the project root for license information.
+#pragma once
+
+#include <memory>
+#include "tree/parse_tree.hpp"
+
+namespace antlr4 {
+
+	namespace atn {
+		class prediction_context;
+	}
+
+	class rule_context : public tree::rule_node
+	{
+	private:
+		const size_t _invoking_state;
+
+		// The prediction contexts computed for this node by prediction_context::from_rule_context, one for SLL (local)
+		// and one for LL (full) prediction. A rule context never changes its parent or invoking state, so once computed
+		// these remain valid for the rest of the parse.
+		mutable std::shared_ptr<atn::prediction_context> _local_prediction_context;
+		mutable std::shared_ptr<atn::prediction_context> _full_prediction_context;
+
+		friend atn::prediction_context;
+
+	public:
+		static const size_t empty_invoking_state = ~static_cast<size_t>(0);
+
+	public:
+		rule_context()
+			: rule_node(nullptr)
+			, _invoking_state(empty_invoking_state)
+		{
+		}
+
+		rule_context(std::shared_ptr<rule_context> const& parent, size_t invoking_state)
+			: rule_node(parent)
+			, _invoking_state(invoking_state)
+		{
+		}
+
+	public:
+		std::shared_ptr<rule_context> parent_context() const
+		{
+			return std::static_pointer_cast<rule_context>(parent());
+		}
+
+		size_t invoking_state() const
+		{
+			return _invoking_state;
+		}
+
+		// A context is empty if there is no invoking state, meaning nobody called the current context.
+		bool is_empty() const
+		{
+			return invoking_state() == empty_invoking_state;
+		}
+
+	private:
+		std::shared_ptr<atn::prediction_context> const& cached_prediction_context(bool full_context) const
+		{
+			return full_context ? _full_prediction_context : _local_prediction_context;
+		}
+
+		void cached_prediction_context(bool full_context, std::shared_ptr<atn::prediction_context> const& value) const
+		{
+			(full_context ? _full_prediction_context : _local_prediction_context) = value;
+		}
+	};
+
+}